@@ -0,0 +1,134 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bus.hpp"
+
+#include "util.hpp"
+
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/message.hpp>
+
+#include <optional>
+#include <string>
+
+namespace metric_blob
+{
+
+using phosphor::logging::entry;
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+sdbusplus::bus_t& BusMetrics::connection()
+{
+    if (!bus)
+    {
+        bus.emplace(sdbusplus::bus::new_default_system());
+    }
+    return *bus;
+}
+
+void BusMetrics::disconnect()
+{
+    eccChanged.reset();
+    eccOwnerChanged.reset();
+    ecc.reset();
+    bus.reset();
+}
+
+bool BusMetrics::getBootDurations(double uptime, BootDurations& boot)
+{
+    if (bootDurations)
+    {
+        boot = *bootDurations;
+        return true;
+    }
+
+    BootTimesMonotonic btm;
+    try
+    {
+        if (!getBootTimesMonotonic(connection(), btm))
+        {
+            return false;
+        }
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        log<level::ERR>("Could not query boot times",
+                        entry("ERROR=%s", e.what()));
+        disconnect();
+        return false;
+    }
+    boot = toBootDurations(btm, uptime);
+    // Until systemd has finished booting, the userspace stage keeps growing.
+    if (btm.finishTime != 0)
+    {
+        bootDurations = boot;
+    }
+    return true;
+}
+
+bool BusMetrics::getEccCounts(EccCounts& eccCounts)
+{
+    try
+    {
+        sdbusplus::bus_t& b = connection();
+        // Subscribe before the first query, so that no change is missed.
+        if (!eccChanged)
+        {
+            namespace rules = sdbusplus::bus::match::rules;
+            eccChanged.emplace(
+                b, rules::propertiesChanged(eccPath, eccInterface),
+                [this](sdbusplus::message_t& m) {
+                    std::string interface;
+                    EccProperties changed;
+                    m.read(interface, changed);
+                    if (ecc)
+                    {
+                        updateEccCounts(changed, *ecc);
+                    }
+                });
+            eccOwnerChanged.emplace(b, rules::nameOwnerChanged(eccService),
+                                    [this](sdbusplus::message_t&) {
+                                        ecc.reset();
+                                    });
+        }
+        // Apply the signals received since the previous snapshot.
+        while (b.process_discard())
+        {}
+
+        if (!ecc)
+        {
+            EccCounts counts;
+            if (!getECCErrorCounts(b, counts))
+            {
+                return false;
+            }
+            ecc = counts;
+        }
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        log<level::ERR>("Could not query ECC error counts",
+                        entry("ERROR=%s", e.what()));
+        disconnect();
+        return false;
+    }
+    eccCounts = *ecc;
+    return true;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,68 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "util.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+
+#include <optional>
+
+namespace metric_blob
+{
+
+/**
+ * Metrics that come from other daemons over D-Bus, through one connection
+ * kept from one snapshot to the next. Values that only change on events are
+ * cached: the boot time breakdown once the boot has finished, and the ECC
+ * error counts, which are kept up to date from PropertiesChanged signals and
+ * only queried again when the ECC daemon restarts. Only the thread running
+ * doWork() may use it.
+ */
+class BusMetrics
+{
+  public:
+    BusMetrics() = default;
+    BusMetrics(const BusMetrics&) = delete;
+    BusMetrics& operator=(const BusMetrics&) = delete;
+
+    /**
+     * Gets how long each stage of the boot took.
+     * @param uptime: current uptime, to time the firmware with if the SoC
+     *     has a power-on counter
+     */
+    bool getBootDurations(double uptime, BootDurations& boot);
+
+    /** Gets the BMC's ECC error counts. */
+    bool getEccCounts(EccCounts& eccCounts);
+
+  private:
+    /** Returns the connection, connecting first if needed. */
+    sdbusplus::bus_t& connection();
+
+    /** Drops the connection and everything learned through it. */
+    void disconnect();
+
+    std::optional<sdbusplus::bus_t> bus;
+    // Declared after the bus, so that they are destroyed before it.
+    std::optional<sdbusplus::bus::match_t> eccChanged;
+    std::optional<sdbusplus::bus::match_t> eccOwnerChanged;
+    std::optional<EccCounts> ecc;
+    std::optional<BootDurations> bootDurations;
+};
+
+} // namespace metric_blob
@@ -0,0 +1,168 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cache.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace metric_blob
+{
+
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+SnapshotCache::SnapshotCache(std::chrono::seconds refreshInterval,
+                             std::chrono::seconds maxAge, size_t topN,
+                             size_t historySize, bool processEvents,
+                             bool taskstats) :
+    refreshInterval(refreshInterval), maxAge(maxAge), history(historySize)
+{
+    state.topN = topN;
+    if (processEvents)
+    {
+        state.processTable = std::make_unique<ProcessTable>();
+    }
+    if (taskstats)
+    {
+        state.taskstats = std::make_unique<TaskStatsClient>();
+    }
+}
+
+void SnapshotCache::start()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    startLocked();
+}
+
+void SnapshotCache::startLocked()
+{
+    if (!worker.joinable())
+    {
+        worker = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+}
+
+std::shared_ptr<const BmcHealthSnapshot>
+    SnapshotCache::acquire(uint32_t sections)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    startLocked();
+
+    Entry& entry = entries[sections];
+    if (maxAge.count() > 0 &&
+        std::chrono::steady_clock::now() - entry.latestTime < maxAge)
+    {
+        if (auto snapshot = entry.latest.lock())
+        {
+            return snapshot;
+        }
+    }
+
+    // Clients arriving while a collection is queued or running share it.
+    if (!entry.pending)
+    {
+        entry.pending = std::make_shared<BmcHealthSnapshot>(sections);
+        cv.notify_one();
+    }
+    return entry.pending;
+}
+
+void SnapshotCache::run(std::stop_token stop)
+{
+    // Health collection must not compete with ipmid or any other daemon for
+    // CPU. On Linux, setpriority() on a thread id only affects that thread.
+    if (setpriority(PRIO_PROCESS, gettid(), 19) < 0)
+    {
+        log<level::WARNING>("Could not lower metric collection priority");
+    }
+
+    std::unique_lock<std::mutex> l(lock);
+    while (!stop.stop_requested())
+    {
+        // Entries are never removed, so this stays valid while unlocked.
+        Entry* next = nullptr;
+        auto hasPending = [this, &next]() {
+            for (auto& [sections, entry] : entries)
+            {
+                if (entry.pending)
+                {
+                    next = &entry;
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (refreshInterval.count() > 0)
+        {
+            auto deadline = lastRefresh + refreshInterval;
+            cv.wait_until(l, stop, deadline, hasPending);
+        }
+        else
+        {
+            cv.wait(l, stop, hasPending);
+        }
+        if (stop.stop_requested())
+        {
+            break;
+        }
+
+        // Publish a periodic collection as pending too, so that clients
+        // arriving in the meantime wait for it instead of queueing another.
+        if (!hasPending())
+        {
+            next = &entries[section::all];
+            next->pending = std::make_shared<BmcHealthSnapshot>();
+        }
+        std::shared_ptr<BmcHealthSnapshot> snapshot = next->pending;
+        // The columnar layout is only collected on demand, like sections.
+        const bool complete = snapshot->getSections() == section::all;
+        auto start = std::chrono::steady_clock::now();
+
+        l.unlock();
+        bool ok = snapshot->doWork(state);
+        if (ok && complete)
+        {
+            history.add(state.record);
+        }
+        l.lock();
+
+        next->pending = nullptr;
+        // A failed collection is reported to the sessions holding it but is
+        // never served from the cache.
+        if (ok)
+        {
+            next->latest = snapshot;
+            next->latestTime = start;
+            if (complete && refreshInterval.count() > 0)
+            {
+                retained = std::move(snapshot);
+            }
+        }
+        if (complete)
+        {
+            lastRefresh = start;
+        }
+    }
+}
+
+} // namespace metric_blob
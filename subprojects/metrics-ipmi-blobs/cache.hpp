@@ -0,0 +1,128 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "metric.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace metric_blob
+{
+
+/**
+ * Keeps the most recent BmcHealthSnapshot and refreshes it from a
+ * low-priority worker thread, so that opening the blob never collects on
+ * the ipmid thread and back-to-back opens do not each pay for a collection.
+ * Snapshots of only some sections are cached separately, and only collected
+ * on request.
+ */
+class SnapshotCache
+{
+  public:
+    /**
+     * @param refreshInterval: how often the worker collects a new snapshot
+     *     on its own. Zero disables periodic refreshes, so snapshots are only
+     *     collected when a client asks for one.
+     * @param maxAge: how old the cached snapshot may be and still be handed
+     *     out. Zero means every acquire() triggers a new collection.
+     * @param topN: how many processes the per-process sections list before
+     *     folding the rest into "(Others)"
+     * @param historySize: how many collections the history keeps a summary
+     *     of
+     * @param processEvents: whether to keep the process list up to date from
+     *     process events instead of walking /proc on every collection
+     * @param taskstats: whether to get process CPU times and delays from
+     *     taskstats
+     */
+    SnapshotCache(std::chrono::seconds refreshInterval,
+                  std::chrono::seconds maxAge, size_t topN,
+                  size_t historySize, bool processEvents = false,
+                  bool taskstats = false);
+    ~SnapshotCache() = default;
+    SnapshotCache(const SnapshotCache&) = delete;
+    SnapshotCache& operator=(const SnapshotCache&) = delete;
+
+    /**
+     * Returns the cached snapshot if it is younger than maxAge. Otherwise
+     * schedules a collection and returns the snapshot being collected,
+     * whose stat() reports "in progress" until the worker is done with it.
+     * Never blocks on collection. Sessions opened within maxAge of each
+     * other get the same snapshot.
+     * @param sections: bitmask of the sections the snapshot must have, and
+     *     the only ones it has
+     */
+    std::shared_ptr<const BmcHealthSnapshot>
+        acquire(uint32_t sections = section::all);
+
+    /**
+     * Starts the worker if it is not running yet, so that periodic refreshes
+     * begin without anyone acquiring a snapshot.
+     */
+    void start();
+
+    /**
+     * Summaries of the last collected snapshots. Only grows once the worker
+     * runs, by one entry per periodic refresh or client request.
+     */
+    const MetricHistory& getHistory() const
+    {
+        return history;
+    }
+
+  private:
+    void startLocked();
+    void run(std::stop_token stop);
+
+    const std::chrono::seconds refreshInterval;
+    const std::chrono::seconds maxAge;
+
+    struct Entry
+    {
+        // Last completed snapshot and when its collection started.
+        std::weak_ptr<const BmcHealthSnapshot> latest;
+        std::chrono::steady_clock::time_point latestTime;
+        // Snapshot handed out to clients but not collected yet.
+        std::shared_ptr<BmcHealthSnapshot> pending;
+    };
+
+    std::mutex lock;
+    std::condition_variable_any cv;
+    // One entry per set of sections asked for.
+    std::unordered_map<uint32_t, Entry> entries;
+    // The cache only owns the last complete snapshot while periodic
+    // refreshes are enabled, since it is about to be replaced anyway;
+    // otherwise snapshots are freed as soon as the last session holding them
+    // closes or expires.
+    std::shared_ptr<const BmcHealthSnapshot> retained;
+    // When the worker last attempted a complete collection, successful or
+    // not.
+    std::chrono::steady_clock::time_point lastRefresh;
+    // Only used by the worker thread.
+    CollectionState state;
+    MetricHistory history;
+    // Started on the first acquire() or start() so that an unused handler
+    // costs nothing.
+    // Declared last so that it is joined before the state above goes away.
+    std::jthread worker;
+};
+
+} // namespace metric_blob
@@ -0,0 +1,109 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "content.hpp"
+
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace metric_blob
+{
+
+std::string_view readAt(const std::vector<char>& data, uint32_t offset,
+                        uint32_t requestedSize)
+{
+    uint32_t size = static_cast<uint32_t>(data.size());
+    if (offset >= size)
+    {
+        return {};
+    }
+    return std::string_view(data.data() + offset,
+                            std::min(requestedSize, size - offset));
+}
+
+EncodedContent::EncodedContent(std::vector<char>&& data) :
+    data(std::move(data))
+{}
+
+std::string_view EncodedContent::read(uint32_t offset,
+                                      uint32_t requestedSize) const
+{
+    return readAt(data, offset, requestedSize);
+}
+
+bool EncodedContent::stat(blobs::BlobMeta& meta) const
+{
+    meta.blobState = blobs::StateFlags::open_read;
+    meta.size = data.size();
+    return true;
+}
+
+CompressedContent::CompressedContent(
+    std::shared_ptr<const BlobContent> content) : content(std::move(content))
+{}
+
+bool CompressedContent::compress() const
+{
+    if (data)
+    {
+        return true;
+    }
+    blobs::BlobMeta meta{};
+    if (!content->stat(meta) ||
+        (meta.blobState & blobs::StateFlags::open_read) == 0)
+    {
+        return false;
+    }
+    std::string_view raw =
+        content->read(0, std::numeric_limits<uint32_t>::max());
+    data = lz4CompressBlock(raw);
+    uncompressedSize = static_cast<uint32_t>(raw.size());
+    return true;
+}
+
+std::string_view CompressedContent::read(uint32_t offset,
+                                         uint32_t requestedSize) const
+{
+    if (!compress())
+    {
+        return {};
+    }
+    return readAt(*data, offset, requestedSize);
+}
+
+bool CompressedContent::stat(blobs::BlobMeta& meta) const
+{
+    if (!compress())
+    {
+        return content->stat(meta);
+    }
+    meta.blobState = blobs::StateFlags::open_read;
+    meta.size = data->size();
+    meta.metadata = {compressionLz4Block};
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        meta.metadata.push_back(
+            static_cast<uint8_t>(uncompressedSize >> shift));
+    }
+    return true;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <blobs-ipmid/blobs.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * What a blob session reads from. Implementations are immutable once
+ * readable, so that one object can be shared by any number of sessions.
+ */
+class BlobContent
+{
+  public:
+    virtual ~BlobContent() = default;
+
+    /**
+     * Reads data from this content
+     * @param offset: offset into the data to read
+     * @param requestedSize: how many bytes to read
+     * @returns Bytes able to read. Returns empty if nothing can be read.
+     */
+    virtual std::string_view read(uint32_t offset,
+                                  uint32_t requestedSize) const = 0;
+
+    /**
+     * Returns information about the amount of readable data and whether the
+     * content has finished populating.
+     * @param meta: Struct to fill with the metadata info
+     */
+    virtual bool stat(blobs::BlobMeta& meta) const = 0;
+};
+
+/** Content that is fully encoded when it is created. */
+class EncodedContent : public BlobContent
+{
+  public:
+    explicit EncodedContent(std::vector<char>&& data);
+
+    std::string_view read(uint32_t offset,
+                          uint32_t requestedSize) const override;
+    bool stat(blobs::BlobMeta& meta) const override;
+
+  private:
+    std::vector<char> data;
+};
+
+/** Compression type reported by CompressedContent session stat metadata. */
+constexpr uint8_t compressionLz4Block = 1;
+
+/**
+ * Serves another content compressed as a single LZ4 block. It is compressed
+ * on the first stat or read after it is complete, and until then stat and
+ * read behave as the other content's do. Session stat metadata is then one
+ * byte of compression type followed by the uncompressed size as a 32-bit
+ * little-endian integer.
+ *
+ * Unlike other contents, this one is filled in by its first reader, so it
+ * must only be used by a single session.
+ */
+class CompressedContent : public BlobContent
+{
+  public:
+    explicit CompressedContent(std::shared_ptr<const BlobContent> content);
+
+    std::string_view read(uint32_t offset,
+                          uint32_t requestedSize) const override;
+    bool stat(blobs::BlobMeta& meta) const override;
+
+  private:
+    /** Compresses the content if it is complete; returns whether it is. */
+    bool compress() const;
+
+    std::shared_ptr<const BlobContent> content;
+    mutable std::optional<std::vector<char>> data;
+    mutable uint32_t uncompressedSize = 0;
+};
+
+/** Returns the part of data that a read at offset can return. */
+std::string_view readAt(const std::vector<char>& data, uint32_t offset,
+                        uint32_t requestedSize);
+
+} // namespace metric_blob
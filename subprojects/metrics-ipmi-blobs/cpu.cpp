@@ -0,0 +1,111 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu.hpp"
+
+#include "util.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+std::vector<CpuStat> collectCpuStats(ProcFileReader& reader)
+{
+    std::vector<CpuStat> cpus;
+    std::string_view content = reader.read("/proc/stat");
+    while (!content.empty())
+    {
+        size_t eol = content.find('\n');
+        std::string_view line = content.substr(0, eol);
+        content = eol == std::string_view::npos ? std::string_view()
+                                                : content.substr(eol + 1);
+
+        CpuStat stat;
+        if (parseProcStatCpuLine(line, stat.cpu, stat.times))
+        {
+            cpus.push_back(stat);
+        }
+        else if (!cpus.empty())
+        {
+            // The cpu lines come first, so the rest of the file, including
+            // the long intr line, is not worth looking at.
+            break;
+        }
+    }
+    return cpus;
+}
+
+// Some counters, iowait in particular, can go backwards on SMP kernels.
+static uint64_t delta(uint64_t current, uint64_t last)
+{
+    return current > last ? current - last : 0;
+}
+
+float CpuStatTracker::update(std::vector<CpuStat>& cpus,
+                             const std::chrono::steady_clock::time_point now)
+{
+    float interval = 0;
+    if (hasPrevious)
+    {
+        interval = std::chrono::duration<float>(now - previousTime).count();
+    }
+
+    std::unordered_map<int, CpuTimes> current;
+    current.reserve(cpus.size());
+    for (CpuStat& stat : cpus)
+    {
+        current.emplace(stat.cpu, stat.times);
+        // A CPU that just came online has nothing to compare with.
+        auto it = previous.find(stat.cpu);
+        if (interval <= 0 || it == previous.end())
+        {
+            continue;
+        }
+        const CpuTimes& cur = stat.times;
+        const CpuTimes& last = it->second;
+        const uint64_t user =
+            delta(cur.user, last.user) + delta(cur.nice, last.nice);
+        const uint64_t system = delta(cur.system, last.system);
+        const uint64_t iowait = delta(cur.iowait, last.iowait);
+        const uint64_t irq = delta(cur.irq, last.irq);
+        const uint64_t softirq = delta(cur.softirq, last.softirq);
+        const uint64_t steal = delta(cur.steal, last.steal);
+        const uint64_t total = user + system + delta(cur.idle, last.idle) +
+                               iowait + irq + softirq + steal;
+        if (total == 0)
+        {
+            continue;
+        }
+        const float scale = 100.0f / static_cast<float>(total);
+        stat.userPercent = static_cast<float>(user) * scale;
+        stat.systemPercent = static_cast<float>(system) * scale;
+        stat.iowaitPercent = static_cast<float>(iowait) * scale;
+        stat.irqPercent = static_cast<float>(irq) * scale;
+        stat.softirqPercent = static_cast<float>(softirq) * scale;
+        stat.stealPercent = static_cast<float>(steal) * scale;
+    }
+
+    // CPUs that went offline are dropped by replacing the table wholesale.
+    previous.swap(current);
+    previousTime = now;
+    hasPrevious = true;
+    return interval;
+}
+
+} // namespace metric_blob
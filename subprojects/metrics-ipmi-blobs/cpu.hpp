@@ -0,0 +1,74 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "util.hpp"
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+/** Time spent by one CPU, or all of them, and its utilization. */
+struct CpuStat
+{
+    // CPU number, or -1 for all CPUs together.
+    int cpu = -1;
+    CpuTimes times;
+    // Percent of the CPU's time since the previous snapshot spent in each
+    // state; user includes nice. Negative if there is no previous snapshot
+    // to compare with.
+    float userPercent = -1;
+    float systemPercent = -1;
+    float iowaitPercent = -1;
+    float irqPercent = -1;
+    float softirqPercent = -1;
+    float stealPercent = -1;
+};
+
+/**
+ * Reads the aggregate and per-CPU times from a single read of /proc/stat.
+ * @param reader: reader whose buffer is used for the read
+ * @returns The aggregate first, then one entry per online CPU.
+ */
+std::vector<CpuStat> collectCpuStats(ProcFileReader& reader);
+
+/**
+ * Remembers the CPU times between snapshots, so that a snapshot can tell one
+ * core pegged by a single daemon apart from the whole system being busy.
+ */
+class CpuStatTracker
+{
+  public:
+    /**
+     * Sets the utilization of every CPU from its times at the previous call,
+     * and remembers the current times for the next one.
+     * @param cpus: CPUs of the current snapshot
+     * @param now: when the times were read
+     * @returns The interval in seconds the utilization is computed over, or
+     *     0 on the first call.
+     */
+    float update(std::vector<CpuStat>& cpus,
+                 std::chrono::steady_clock::time_point now);
+
+  private:
+    std::unordered_map<int, CpuTimes> previous;
+    std::chrono::steady_clock::time_point previousTime;
+    bool hasPrevious = false;
+};
+
+} // namespace metric_blob
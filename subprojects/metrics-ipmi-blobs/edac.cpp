@@ -0,0 +1,147 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "edac.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace metric_blob
+{
+
+namespace
+{
+
+bool readCount(int fd, uint64_t& count)
+{
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf), 0);
+    if (n <= 0)
+    {
+        return false;
+    }
+    auto [ptr, ec] = std::from_chars(buf, buf + n, count);
+    return ec == std::errc();
+}
+
+int32_t toCount(uint64_t count)
+{
+    return static_cast<int32_t>(
+        std::min<uint64_t>(count, std::numeric_limits<int32_t>::max()));
+}
+
+} // namespace
+
+EdacCounters::EdacCounters(std::string root) : root(std::move(root)) {}
+
+EdacCounters::~EdacCounters()
+{
+    close();
+}
+
+void EdacCounters::open()
+{
+    opened = true;
+    DIR* dir = opendir(root.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+    while (struct dirent* ent = readdir(dir))
+    {
+        std::string_view name(ent->d_name);
+        if (!name.starts_with("mc"))
+        {
+            continue;
+        }
+        const char* end = name.data() + name.size();
+        int id;
+        auto [ptr, ec] = std::from_chars(name.data() + 2, end, id);
+        if (ec != std::errc() || ptr != end)
+        {
+            continue;
+        }
+        std::string path = root + "/" + ent->d_name + "/";
+        int ceFd = ::open((path + "ce_count").c_str(), O_RDONLY | O_CLOEXEC);
+        int ueFd = ::open((path + "ue_count").c_str(), O_RDONLY | O_CLOEXEC);
+        if (ceFd < 0 || ueFd < 0)
+        {
+            if (ceFd >= 0)
+            {
+                ::close(ceFd);
+            }
+            if (ueFd >= 0)
+            {
+                ::close(ueFd);
+            }
+            continue;
+        }
+        controllers.push_back({ceFd, ueFd});
+    }
+    closedir(dir);
+}
+
+void EdacCounters::close()
+{
+    for (const Controller& c : controllers)
+    {
+        ::close(c.ceFd);
+        ::close(c.ueFd);
+    }
+    controllers.clear();
+    opened = false;
+}
+
+bool EdacCounters::read(EccCounts& eccCounts)
+{
+    if (!opened)
+    {
+        open();
+    }
+    if (controllers.empty())
+    {
+        return false;
+    }
+
+    uint64_t ce = 0;
+    uint64_t ue = 0;
+    for (const Controller& c : controllers)
+    {
+        uint64_t ceCount;
+        uint64_t ueCount;
+        if (!readCount(c.ceFd, ceCount) || !readCount(c.ueFd, ueCount))
+        {
+            close();
+            return false;
+        }
+        ce += ceCount;
+        ue += ueCount;
+    }
+    eccCounts.correctableErrCount = toCount(ce);
+    eccCounts.uncorrectableErrCount = toCount(ue);
+    return true;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,65 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "util.hpp"
+
+#include <string>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Reads the ECC error counts of every EDAC memory controller straight from
+ * sysfs, which takes no other daemon and well under a millisecond. The
+ * ce_count and ue_count attributes are opened once and re-read with pread(),
+ * which makes sysfs regenerate their content.
+ */
+class EdacCounters
+{
+  public:
+    /** @param root: directory holding the mc<N> controller directories */
+    explicit EdacCounters(std::string root = "/sys/devices/system/edac/mc");
+    ~EdacCounters();
+    EdacCounters(const EdacCounters&) = delete;
+    EdacCounters& operator=(const EdacCounters&) = delete;
+
+    /**
+     * Sums the counts of all controllers.
+     * @returns false if there is no EDAC controller or a count could not be
+     *     read. Controllers are looked for on the first call and again after
+     *     a read error.
+     */
+    bool read(EccCounts& eccCounts);
+
+  private:
+    struct Controller
+    {
+        int ceFd;
+        int ueFd;
+    };
+
+    /** Opens the counts of every controller, once. */
+    void open();
+    void close();
+
+    std::string root;
+    std::vector<Controller> controllers;
+    bool opened = false;
+};
+
+} // namespace metric_blob
@@ -0,0 +1,223 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "encode.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+namespace
+{
+
+bool vectorWrite(pb_ostream_t* stream, const pb_byte_t* buf, size_t count)
+{
+    auto& out = *reinterpret_cast<std::vector<char>*>(stream->state);
+    out.insert(out.end(), buf, buf + count);
+    return true;
+}
+
+// A stream that appends to out, growing it as needed.
+pb_ostream_t vectorStream(std::vector<char>& out)
+{
+    pb_ostream_t stream = {};
+    stream.callback = vectorWrite;
+    stream.state = &out;
+    stream.max_size = SIZE_MAX;
+    return stream;
+}
+
+constexpr size_t varintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+// Appends msg as the length-delimited field `tag` of the enclosing message.
+bool encodeSection(std::vector<char>& out, uint32_t tag,
+                   const pb_msgdesc_t* fields, const void* msg,
+                   const char*& error)
+{
+    pb_ostream_t stream = vectorStream(out);
+    if (!pb_encode_tag(&stream, PB_WT_STRING, tag))
+    {
+        error = PB_GET_ERROR(&stream);
+        return false;
+    }
+
+    // The length is only known once the section is written, so leave room
+    // for the longest varint a 32-bit length can take and close the gap
+    // afterwards. Moving a few KiB is much cheaper than a sizing pass.
+    constexpr size_t maxLenSize = 5;
+    const size_t lenPos = out.size();
+    out.resize(lenPos + maxLenSize);
+    if (!pb_encode(&stream, fields, msg))
+    {
+        error = PB_GET_ERROR(&stream);
+        return false;
+    }
+
+    const size_t len = out.size() - lenPos - maxLenSize;
+    pb_byte_t lenBuf[maxLenSize];
+    pb_ostream_t lenStream = pb_ostream_from_buffer(lenBuf, sizeof(lenBuf));
+    if (!pb_encode_varint(&lenStream, len))
+    {
+        error = PB_GET_ERROR(&lenStream);
+        return false;
+    }
+    const size_t lenSize = lenStream.bytes_written;
+    std::memmove(out.data() + lenPos + lenSize,
+                 out.data() + lenPos + maxLenSize, len);
+    std::memcpy(out.data() + lenPos, lenBuf, lenSize);
+    out.resize(lenPos + lenSize + len);
+    return true;
+}
+
+} // namespace
+
+bool pbEncodeStringEntries(pb_ostream_t* stream, const pb_field_iter_t* field,
+                           const std::vector<std::string_view>& strs)
+{
+    constexpr uint32_t valueTag =
+        bmcmetrics_metricproto_BmcStringTable_StringEntry_value_tag;
+    constexpr size_t valueTagSize = varintSize(valueTag << 3);
+    for (const auto& str : strs)
+    {
+        const size_t entrySize =
+            valueTagSize + varintSize(str.size()) + str.size();
+        if (!pb_encode_tag_for_field(stream, field) ||
+            !pb_encode_varint(stream, entrySize) ||
+            !pb_encode_tag(stream, PB_WT_STRING, valueTag) ||
+            !pb_encode_string(stream,
+                              reinterpret_cast<const pb_byte_t*>(str.data()),
+                              str.size()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool encodeSnapshot(const bmcmetrics_metricproto_BmcMetricSnapshot& snapshot,
+                    std::vector<char>& out, const char*& error)
+{
+    struct Section
+    {
+        bool has;
+        uint32_t tag;
+        const pb_msgdesc_t* fields;
+        const void* msg;
+    };
+    // In field number order, as pb_encode() would write them.
+    const Section sections[] = {
+        {snapshot.has_string_table,
+         bmcmetrics_metricproto_BmcMetricSnapshot_string_table_tag,
+         bmcmetrics_metricproto_BmcStringTable_fields, &snapshot.string_table},
+        {snapshot.has_memory_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_memory_metric_tag,
+         bmcmetrics_metricproto_BmcMemoryMetric_fields,
+         &snapshot.memory_metric},
+        {snapshot.has_uptime_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_uptime_metric_tag,
+         bmcmetrics_metricproto_BmcUptimeMetric_fields,
+         &snapshot.uptime_metric},
+        {snapshot.has_storage_space_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_storage_space_metric_tag,
+         bmcmetrics_metricproto_BmcDiskSpaceMetric_fields,
+         &snapshot.storage_space_metric},
+        {snapshot.has_procstat_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_procstat_metric_tag,
+         bmcmetrics_metricproto_BmcProcStatMetric_fields,
+         &snapshot.procstat_metric},
+        {snapshot.has_fdstat_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_fdstat_metric_tag,
+         bmcmetrics_metricproto_BmcFdStatMetric_fields,
+         &snapshot.fdstat_metric},
+        {snapshot.has_ecc_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_ecc_metric_tag,
+         bmcmetrics_metricproto_BmcECCMetric_fields, &snapshot.ecc_metric},
+        {snapshot.has_procmem_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_procmem_metric_tag,
+         bmcmetrics_metricproto_BmcProcMemMetric_fields,
+         &snapshot.procmem_metric},
+        {snapshot.has_procio_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_procio_metric_tag,
+         bmcmetrics_metricproto_BmcProcIoMetric_fields,
+         &snapshot.procio_metric},
+        {snapshot.has_pressure_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_pressure_metric_tag,
+         bmcmetrics_metricproto_BmcPressureMetric_fields,
+         &snapshot.pressure_metric},
+        {snapshot.has_netdev_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_netdev_metric_tag,
+         bmcmetrics_metricproto_BmcNetDevMetric_fields,
+         &snapshot.netdev_metric},
+        {snapshot.has_cpu_metric,
+         bmcmetrics_metricproto_BmcMetricSnapshot_cpu_metric_tag,
+         bmcmetrics_metricproto_BmcCpuMetric_fields, &snapshot.cpu_metric},
+    };
+
+    out.clear();
+    for (const Section& section : sections)
+    {
+        if (section.has && !encodeSection(out, section.tag, section.fields,
+                                          section.msg, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool encodeHistory(
+    const bmcmetrics_metricproto_BmcStringTable& stringTable,
+    const std::vector<bmcmetrics_metricproto_BmcMetricHistory_Sample>& samples,
+    std::vector<char>& out, const char*& error)
+{
+    constexpr uint32_t stringTableTag =
+        bmcmetrics_metricproto_BmcMetricHistory_string_table_tag;
+    constexpr uint32_t samplesTag =
+        bmcmetrics_metricproto_BmcMetricHistory_samples_tag;
+
+    out.clear();
+    if (!encodeSection(out, stringTableTag,
+                       bmcmetrics_metricproto_BmcStringTable_fields,
+                       &stringTable, error))
+    {
+        return false;
+    }
+    // Each element of a repeated message field is framed like a section.
+    for (const auto& sample : samples)
+    {
+        if (!encodeSection(
+                out, samplesTag,
+                bmcmetrics_metricproto_BmcMetricHistory_Sample_fields, &sample,
+                error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,160 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "metricblob.pb.n.h"
+
+#include <pb_encode.h>
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace metric_blob
+{
+
+template <typename T>
+inline constexpr auto pbEncodeStr =
+    [](pb_ostream_t* stream, const pb_field_iter_t* field,
+       void* const* arg) noexcept {
+        static_assert(sizeof(*std::declval<T>().data()) == sizeof(pb_byte_t));
+        const auto& s = *reinterpret_cast<const T*>(*arg);
+        return pb_encode_tag_for_field(stream, field) &&
+               pb_encode_string(stream,
+                                reinterpret_cast<const pb_byte_t*>(s.data()),
+                                s.size());
+    };
+
+template <typename T>
+inline pb_callback_t pbStrEncoder(const T& t) noexcept
+{
+    return {{.encode = pbEncodeStr<T>}, const_cast<T*>(&t)};
+}
+
+template <auto fields, typename T>
+inline constexpr auto pbEncodeSubs =
+    [](pb_ostream_t* stream, const pb_field_iter_t* field,
+       void* const* arg) noexcept {
+        for (const auto& sub : *reinterpret_cast<const std::vector<T>*>(*arg))
+        {
+            if (!pb_encode_tag_for_field(stream, field) ||
+                !pb_encode_submessage(stream, fields, &sub))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+template <auto fields, typename T>
+inline pb_callback_t pbSubsEncoder(const std::vector<T>& t)
+{
+    return {{.encode = pbEncodeSubs<fields, T>},
+            const_cast<std::vector<T>*>(&t)};
+}
+
+/**
+ * Writes a repeated scalar field in packed form: one tag and length followed
+ * by the values, instead of a tag per value. Floats are written as fixed32,
+ * signed integers zigzag encoded as sint32/sint64 expect, and unsigned
+ * integers as plain varints. An empty vector writes nothing.
+ */
+template <typename T>
+inline constexpr auto pbEncodePacked =
+    [](pb_ostream_t* stream, const pb_field_iter_t* field,
+       void* const* arg) noexcept {
+        static_assert(std::is_same_v<T, float> || std::is_integral_v<T>);
+        const auto& values = *reinterpret_cast<const std::vector<T>*>(*arg);
+        if (values.empty())
+        {
+            return true;
+        }
+        auto encodeValues = [&values](pb_ostream_t* s) {
+            for (T value : values)
+            {
+                bool ok;
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    ok = pb_encode_fixed32(s, &value);
+                }
+                else if constexpr (std::is_signed_v<T>)
+                {
+                    ok = pb_encode_svarint(s, value);
+                }
+                else
+                {
+                    ok = pb_encode_varint(s, value);
+                }
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        pb_ostream_t sizing = PB_OSTREAM_SIZING;
+        return encodeValues(&sizing) &&
+               pb_encode_tag(stream, PB_WT_STRING, field->tag) &&
+               pb_encode_varint(stream, sizing.bytes_written) &&
+               encodeValues(stream);
+    };
+
+template <typename T>
+inline pb_callback_t pbPackedEncoder(const std::vector<T>& t)
+{
+    return {{.encode = pbEncodePacked<T>}, const_cast<std::vector<T>*>(&t)};
+}
+
+/**
+ * Writes the entries of a BmcStringTable as the repeated field being encoded.
+ * Each StringEntry is framed by hand, since its size is known upfront, instead
+ * of through pb_encode_submessage() which would run its callback twice.
+ */
+bool pbEncodeStringEntries(pb_ostream_t* stream, const pb_field_iter_t* field,
+                           const std::vector<std::string_view>& strs);
+
+/**
+ * Encodes a snapshot into out, which is cleared first, in a single pass.
+ *
+ * pb_encode() needs the size of every submessage before writing it, so it
+ * runs each section, and every callback in it, once to size it and once to
+ * write it, on top of the sizing pass needed for a right-sized buffer. Here
+ * each present section is encoded once straight into out, and its length
+ * prefix is filled in afterwards.
+ * @param snapshot: the snapshot to encode
+ * @param out: receives the encoded message
+ * @param error: set to the nanopb error message on failure
+ * @returns true on success
+ */
+bool encodeSnapshot(const bmcmetrics_metricproto_BmcMetricSnapshot& snapshot,
+                    std::vector<char>& out, const char*& error);
+
+/**
+ * Encodes a BmcMetricHistory into out, which is cleared first, in a single
+ * pass like encodeSnapshot().
+ * @param stringTable: the string table the samples refer to
+ * @param samples: the samples, oldest first
+ * @param out: receives the encoded message
+ * @param error: set to the nanopb error message on failure
+ * @returns true on success
+ */
+bool encodeHistory(
+    const bmcmetrics_metricproto_BmcStringTable& stringTable,
+    const std::vector<bmcmetrics_metricproto_BmcMetricHistory_Sample>& samples,
+    std::vector<char>& out, const char*& error);
+
+} // namespace metric_blob
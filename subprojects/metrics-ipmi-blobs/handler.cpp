@@ -14,8 +14,13 @@
 
 #include "handler.hpp"
 
+#include "metric_conf.hpp"
+
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -26,18 +31,80 @@ namespace blobs
 namespace
 {
 constexpr std::string_view metricPath("/metric/snapshot");
+constexpr std::string_view historyPath("/metric/history");
+constexpr bool hasHistory = HISTORY_SIZE > 0;
+
+// Blob-specific open flag asking for the session to be LZ4-compressed.
+constexpr uint16_t openCompressed = 1 << 8;
+// Blob-specific open flag asking for the per-process sections as columns.
+constexpr uint16_t openColumnar = 1 << 9;
+
+struct SectionBlob
+{
+    std::string_view path;
+    uint32_t sections;
+};
+
+// Snapshots of a single section, for clients that poll one of them more often
+// than the rest.
+constexpr std::array<SectionBlob, 11> sectionBlobs = {{
+    {"/metric/snapshot/memory", metric_blob::section::memory},
+    {"/metric/snapshot/uptime", metric_blob::section::uptime},
+    {"/metric/snapshot/storage", metric_blob::section::storage},
+    {"/metric/snapshot/procstat", metric_blob::section::procstat},
+    {"/metric/snapshot/fdstat", metric_blob::section::fdstat},
+    {"/metric/snapshot/ecc", metric_blob::section::ecc},
+    {"/metric/snapshot/procmem", metric_blob::section::procmem},
+    {"/metric/snapshot/procio", metric_blob::section::procio},
+    {"/metric/snapshot/pressure", metric_blob::section::pressure},
+    {"/metric/snapshot/netdev", metric_blob::section::netdev},
+    {"/metric/snapshot/cpu", metric_blob::section::cpu},
+}};
+
+// Returns the sections of the snapshot blob at path, if it is one.
+std::optional<uint32_t> snapshotSections(std::string_view path)
+{
+    if (path == metricPath)
+    {
+        return metric_blob::section::all;
+    }
+    for (const SectionBlob& blob : sectionBlobs)
+    {
+        if (path == blob.path)
+        {
+            return blob.sections;
+        }
+    }
+    return std::nullopt;
+}
 } // namespace
 
+MetricBlobHandler::MetricBlobHandler() :
+    cache(std::make_unique<metric_blob::SnapshotCache>(
+        std::chrono::seconds(SNAPSHOT_REFRESH_INTERVAL_SEC),
+        std::chrono::seconds(SNAPSHOT_MAX_AGE_SEC), SNAPSHOT_TOP_PROCESSES,
+        HISTORY_SIZE, PROCESS_EVENTS, TASKSTATS))
+{}
+
 bool MetricBlobHandler::canHandleBlob(const std::string& path)
 {
-    return path == metricPath;
+    return snapshotSections(path) || (hasHistory && path == historyPath);
 }
 
-// A blob handler may have multiple Blobs. For this blob handler, there is only
-// one blob.
+// The snapshot blob, one blob per snapshot section, and the history of past
+// snapshots unless it is disabled.
 std::vector<std::string> MetricBlobHandler::getBlobIds()
 {
-    return {std::string(metricPath)};
+    std::vector<std::string> ids = {std::string(metricPath)};
+    for (const SectionBlob& blob : sectionBlobs)
+    {
+        ids.emplace_back(blob.path);
+    }
+    if (hasHistory)
+    {
+        ids.emplace_back(historyPath);
+    }
+    return ids;
 }
 
 // BmcBlobDelete (7) is not supported.
@@ -75,16 +142,40 @@ bool MetricBlobHandler::open(uint16_t session, uint16_t flags,
     {
         return false;
     }
-    if (path == metricPath)
+    std::shared_ptr<const metric_blob::BlobContent> content;
+    if (auto sections = snapshotSections(path))
     {
-        std::unique_ptr<metric_blob::BmcHealthSnapshot> bhs =
-            std::make_unique<metric_blob::BmcHealthSnapshot>();
-        bhs.get()->doWork();
-        sessions[session] = nullptr;
-        sessions[session] = std::move(bhs);
-        return true;
+        // Collection runs on the cache's worker thread so that ipmid can keep
+        // serving other commands. If the cached snapshot is too old, clients
+        // poll the session stat until bit 8 clears. Both layouts are cached
+        // separately.
+        if (flags & openColumnar)
+        {
+            *sections |= metric_blob::section::columnar;
+        }
+        content = cache->acquire(*sections);
     }
-    return false;
+    else if (path == historyPath)
+    {
+        // The history is made of fixed-size records, so encoding it here is
+        // cheap. It starts filling once the worker runs, which the first
+        // open of either blob triggers.
+        cache->start();
+        content = cache->getHistory().encode();
+    }
+    if (!content)
+    {
+        return false;
+    }
+    // Sessions share the content but compress it separately, which is cheap
+    // next to sending it.
+    if (flags & openCompressed)
+    {
+        content = std::make_shared<metric_blob::CompressedContent>(
+            std::move(content));
+    }
+    sessions[session] = std::move(content);
+    return true;
 }
 
 // BmcBlobRead(3) handler.
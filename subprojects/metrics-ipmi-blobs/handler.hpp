@@ -15,10 +15,13 @@
 #pragma once
 
 #include <blobs-ipmid/blobs.hpp>
+#include <cache.hpp>
 #include <metric.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace blobs
@@ -27,7 +30,7 @@ namespace blobs
 class MetricBlobHandler : public GenericBlobInterface
 {
   public:
-    MetricBlobHandler() = default;
+    MetricBlobHandler();
     ~MetricBlobHandler() = default;
     MetricBlobHandler(const MetricBlobHandler&) = delete;
     MetricBlobHandler& operator=(const MetricBlobHandler&) = delete;
@@ -53,9 +56,10 @@ class MetricBlobHandler : public GenericBlobInterface
 
   private:
     bool isReadOnlyOpenFlags(const uint16_t flag);
-    /* Every session gets its own BmcHealthSnapshot instance. */
+    /* Sessions opened while the cached snapshot is fresh share it. */
+    std::unique_ptr<metric_blob::SnapshotCache> cache;
     std::unordered_map<uint16_t,
-                       std::unique_ptr<metric_blob::BmcHealthSnapshot>>
+                       std::shared_ptr<const metric_blob::BlobContent>>
         sessions;
 };
 
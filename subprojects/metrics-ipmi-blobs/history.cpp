@@ -0,0 +1,141 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "history.hpp"
+
+#include "metricblob.pb.n.h"
+
+#include "encode.hpp"
+#include "string_pool.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+MetricHistory::MetricHistory(size_t capacity) : ring(capacity) {}
+
+void MetricHistory::add(const HistoryRecord& record)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (ring.empty())
+    {
+        return;
+    }
+    ring[next] = record;
+    next = (next + 1) % ring.size();
+    count = std::min(count + 1, ring.size());
+}
+
+std::vector<HistoryRecord> MetricHistory::records() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<HistoryRecord> ret;
+    if (count == 0)
+    {
+        return ret;
+    }
+    ret.reserve(count);
+    const size_t first = (next + ring.size() - count) % ring.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        ret.push_back(ring[(first + i) % ring.size()]);
+    }
+    return ret;
+}
+
+std::shared_ptr<const BlobContent> MetricHistory::encode() const
+{
+    // Copy the records out so that the collection thread is not held up
+    // while they are encoded.
+    const std::vector<HistoryRecord> recs = records();
+
+    StringPool strings;
+    strings.beginSnapshot();
+    std::vector<bmcmetrics_metricproto_BmcMetricHistory_Sample> samples;
+    std::vector<std::vector<bmcmetrics_metricproto_BmcMetricHistory_TopProcess>>
+        processes(recs.size());
+    samples.reserve(recs.size());
+    for (size_t i = 0; i < recs.size(); ++i)
+    {
+        const HistoryRecord& r = recs[i];
+        for (size_t p = 0; p < r.numProcesses; ++p)
+        {
+            const HistoryRecord::Process& proc = r.processes[p];
+            std::string_view comm(proc.comm.data(),
+                                  strnlen(proc.comm.data(), proc.comm.size()));
+            processes[i].emplace_back(
+                bmcmetrics_metricproto_BmcMetricHistory_TopProcess{
+                    .sidx_comm = strings.getStringID(comm),
+                    .has_cpu_percent = proc.cpuPercent >= 0,
+                    .cpu_percent = proc.cpuPercent,
+                    .rss_kib = static_cast<int32_t>(proc.rssKib),
+                });
+        }
+        samples.emplace_back(bmcmetrics_metricproto_BmcMetricHistory_Sample{
+            .uptime = r.uptime,
+            .mem_available = r.memAvailableKib,
+            .has_cpu_busy_percent = r.cpuBusyPercent >= 0,
+            .cpu_busy_percent = r.cpuBusyPercent,
+            .has_cpu_iowait_percent = r.cpuIowaitPercent >= 0,
+            .cpu_iowait_percent = r.cpuIowaitPercent,
+            .has_cpu_some_avg10 = r.cpuSomeAvg10 >= 0,
+            .cpu_some_avg10 = r.cpuSomeAvg10,
+            .has_memory_some_avg10 = r.memorySomeAvg10 >= 0,
+            .memory_some_avg10 = r.memorySomeAvg10,
+            .has_memory_full_avg10 = r.memoryFullAvg10 >= 0,
+            .memory_full_avg10 = r.memoryFullAvg10,
+            .has_io_some_avg10 = r.ioSomeAvg10 >= 0,
+            .io_some_avg10 = r.ioSomeAvg10,
+            .has_io_full_avg10 = r.ioFullAvg10 >= 0,
+            .io_full_avg10 = r.ioFullAvg10,
+            .top_processes = pbSubsEncoder<
+                bmcmetrics_metricproto_BmcMetricHistory_TopProcess_fields>(
+                processes[i]),
+        });
+    }
+
+    static constexpr auto stcb = [](pb_ostream_t* stream,
+                                    const pb_field_t* field,
+                                    void* const* arg) noexcept {
+        const auto& strings = *reinterpret_cast<const StringPool*>(*arg);
+        return pbEncodeStringEntries(stream, field, strings.strings());
+    };
+    const bmcmetrics_metricproto_BmcStringTable stringTable = {
+        .entries = {{.encode = stcb}, &strings},
+    };
+
+    std::vector<char> out;
+    const char* error = nullptr;
+    if (!encodeHistory(stringTable, samples, out, error))
+    {
+        auto msg = std::format("Writing history pb msg: {}", error);
+        log<level::ERR>(msg.c_str());
+        return nullptr;
+    }
+    return std::make_shared<EncodedContent>(std::move(out));
+}
+
+} // namespace metric_blob
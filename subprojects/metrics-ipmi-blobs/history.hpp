@@ -0,0 +1,95 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "content.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * The main health indicators of one snapshot, small and fixed-size so that
+ * an hour of them can be kept in memory. Negative values are unknown.
+ */
+struct HistoryRecord
+{
+    struct Process
+    {
+        // comm, which the kernel caps at 15 characters, NUL-terminated.
+        std::array<char, 16> comm = {};
+        float cpuPercent = -1;
+        uint32_t rssKib = 0;
+    };
+    static constexpr size_t maxProcesses = 3;
+
+    float uptime = -1;
+    int32_t memAvailableKib = -1;
+    float cpuBusyPercent = -1;
+    float cpuIowaitPercent = -1;
+    float cpuSomeAvg10 = -1;
+    float memorySomeAvg10 = -1;
+    float memoryFullAvg10 = -1;
+    float ioSomeAvg10 = -1;
+    float ioFullAvg10 = -1;
+    // Processes using the most CPU, best first.
+    uint8_t numProcesses = 0;
+    std::array<Process, maxProcesses> processes;
+};
+
+/**
+ * Keeps the last records in a fixed-size ring, so that a client can fetch
+ * an hour of trends in one read instead of polling snapshots. Written by the
+ * collection thread and read by the blob handler.
+ */
+class MetricHistory
+{
+  public:
+    /**
+     * @param capacity: how many records to keep; the oldest one is dropped
+     *     when a record is added to a full history
+     */
+    explicit MetricHistory(size_t capacity);
+    MetricHistory(const MetricHistory&) = delete;
+    MetricHistory& operator=(const MetricHistory&) = delete;
+
+    void add(const HistoryRecord& record);
+
+    /**
+     * Returns the records, oldest first.
+     */
+    std::vector<HistoryRecord> records() const;
+
+    /**
+     * Encodes the records as a BmcMetricHistory.
+     * @returns The encoded history, or nullptr if encoding failed.
+     */
+    std::shared_ptr<const BlobContent> encode() const;
+
+  private:
+    mutable std::mutex lock;
+    std::vector<HistoryRecord> ring;
+    // Where the next record goes, and how many slots are in use.
+    size_t next = 0;
+    size_t count = 0;
+};
+
+} // namespace metric_blob
@@ -0,0 +1,143 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+namespace
+{
+
+// Limits of the LZ4 block format: matches are at least 4 bytes long and at
+// most 64 KiB back, the last match starts at least 12 bytes before the end,
+// and the last 5 bytes are always literals.
+constexpr size_t minMatch = 4;
+constexpr size_t maxOffset = 65535;
+constexpr size_t mfLimit = 12;
+constexpr size_t lastLiterals = 5;
+
+constexpr int hashBits = 12;
+
+uint32_t load32(std::string_view data, size_t pos)
+{
+    uint32_t v;
+    std::memcpy(&v, data.data() + pos, sizeof(v));
+    return v;
+}
+
+size_t hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+// Lengths that do not fit in their 4 bits of the token continue in bytes of
+// 255 until the remainder.
+void appendLength(std::vector<char>& out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        out.push_back(static_cast<char>(255));
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+void appendLiterals(std::vector<char>& out, std::string_view literals,
+                    size_t matchCode)
+{
+    size_t size = literals.size();
+    out.push_back(
+        static_cast<char>((std::min<size_t>(size, 15) << 4) | matchCode));
+    if (size >= 15)
+    {
+        appendLength(out, size - 15);
+    }
+    out.insert(out.end(), literals.begin(), literals.end());
+}
+
+void appendSequence(std::vector<char>& out, std::string_view literals,
+                    size_t offset, size_t matchLength)
+{
+    size_t code = matchLength - minMatch;
+    appendLiterals(out, literals, std::min<size_t>(code, 15));
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (code >= 15)
+    {
+        appendLength(out, code - 15);
+    }
+}
+
+} // namespace
+
+std::vector<char> lz4CompressBlock(std::string_view data)
+{
+    std::vector<char> out;
+    out.reserve(data.size() + data.size() / 255 + 16);
+
+    // Last position each hashed 4-byte sequence was seen at, plus one so
+    // that 0 means never.
+    std::vector<uint32_t> table(size_t{1} << hashBits, 0);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + mfLimit <= data.size())
+    {
+        uint32_t sequence = load32(data, pos);
+        uint32_t& slot = table[hash(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+        if (candidate == 0 || pos + 1 - candidate > maxOffset ||
+            load32(data, candidate - 1) != sequence)
+        {
+            ++pos;
+            continue;
+        }
+        --candidate;
+
+        size_t length = minMatch;
+        const size_t matchEnd = data.size() - lastLiterals;
+        while (pos + length < matchEnd &&
+               data[candidate + length] == data[pos + length])
+        {
+            ++length;
+        }
+        // The match may also start earlier than where it was found.
+        while (pos > anchor && candidate > 0 &&
+               data[pos - 1] == data[candidate - 1])
+        {
+            --pos;
+            --candidate;
+            ++length;
+        }
+
+        appendSequence(out, data.substr(anchor, pos - anchor),
+                       pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    appendLiterals(out, data.substr(anchor), 0);
+    return out;
+}
+
+} // namespace metric_blob
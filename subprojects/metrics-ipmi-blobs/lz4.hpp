@@ -0,0 +1,35 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Compresses data as a single LZ4 block (not an LZ4 frame): a sequence of
+ * literal runs and back-references of up to 64 KiB, which clients decode
+ * with LZ4_decompress_safe() or any other LZ4 block decoder, given the
+ * uncompressed size. This is a simple greedy compressor with a small hash
+ * table, good enough for the few KiB of a snapshot.
+ * @param data: bytes to compress
+ * @returns The compressed block. Incompressible data grows by about 0.4%.
+ */
+std::vector<char> lz4CompressBlock(std::string_view data);
+
+} // namespace metric_blob
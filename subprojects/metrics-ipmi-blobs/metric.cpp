@@ -16,6 +16,11 @@
 
 #include "metricblob.pb.n.h"
 
+#include "cpu.hpp"
+#include "encode.hpp"
+#include "net.hpp"
+#include "proc.hpp"
+#include "topk.hpp"
 #include "util.hpp"
 
 #include <pb_encode.h>
@@ -23,11 +28,13 @@
 
 #include <phosphor-logging/log.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
-#include <filesystem>
-#include <sstream>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace metric_blob
 {
@@ -36,289 +43,414 @@ using phosphor::logging::entry;
 using phosphor::logging::log;
 using level = phosphor::logging::level;
 
-BmcHealthSnapshot::BmcHealthSnapshot() :
-    done(false), stringId(0), ticksPerSec(0)
+BmcHealthSnapshot::BmcHealthSnapshot(uint32_t sections) :
+    done(false), failed(false), sections(sections), ticksPerSec(0)
 {}
 
-template <typename T>
-static constexpr auto pbEncodeStr =
-    [](pb_ostream_t* stream, const pb_field_iter_t* field,
-       void* const* arg) noexcept {
-        static_assert(sizeof(*std::declval<T>().data()) == sizeof(pb_byte_t));
-        const auto& s = *reinterpret_cast<const T*>(*arg);
-        return pb_encode_tag_for_field(stream, field) &&
-               pb_encode_string(stream,
-                                reinterpret_cast<const pb_byte_t*>(s.data()),
-                                s.size());
-    };
-
-template <typename T>
-static pb_callback_t pbStrEncoder(const T& t) noexcept
+// Processes with the highest CPU usage since the previous snapshot are ranked
+// first, or those with the longest utime + stime if there was none.
+// Tie breaking is done with utime + stime, cmdline then tcomm.
+static auto procStatKey(const ProcessInfo& p)
 {
-    return {{.encode = pbEncodeStr<T>}, const_cast<T*>(&t)};
+    return std::tuple<float, float, const std::string&, const std::string&>(
+        -p.cpuPercent, -(p.utime + p.stime), p.cmdline, p.tcomm);
 }
 
-template <auto fields, typename T>
-static constexpr auto pbEncodeSubs =
-    [](pb_ostream_t* stream, const pb_field_iter_t* field,
-       void* const* arg) noexcept {
-        for (const auto& sub : *reinterpret_cast<const std::vector<T>*>(*arg))
-        {
-            if (!pb_encode_tag_for_field(stream, field) ||
-                !pb_encode_submessage(stream, fields, &sub))
-            {
-                return false;
-            }
-        }
-        return true;
-    };
+// Processes with the largest fdCount goes first.
+// Tie-breaking using cmdline then tcomm.
+static auto fdStatKey(const ProcessInfo& p)
+{
+    return std::tuple<int, const std::string&, const std::string&>(
+        -p.fdCount, p.cmdline, p.tcomm);
+}
 
-template <auto fields, typename T>
-static pb_callback_t pbSubsEncoder(const std::vector<T>& t)
+// Processes with the largest RSS go first.
+// Tie-breaking using cmdline then tcomm.
+static auto procMemKey(const ProcessInfo& p)
 {
-    return {{.encode = pbEncodeSubs<fields, T>},
-            const_cast<std::vector<T>*>(&t)};
+    return std::tuple<int64_t, const std::string&, const std::string&>(
+        -static_cast<int64_t>(p.rssKib), p.cmdline, p.tcomm);
 }
 
-struct ProcStatEntry
+// Processes writing the most to storage since the previous snapshot go first,
+// or those that wrote the most overall if there was none.
+// Tie-breaking using bytes read, cmdline then tcomm.
+static auto procIoKey(const ProcessInfo& p)
 {
-    std::string cmdline;
-    std::string tcomm;
-    float utime;
-    float stime;
+    return std::tuple<float, int64_t, int64_t, const std::string&,
+                      const std::string&>(
+        -p.writeBytesPerSec, -static_cast<int64_t>(p.io.writeBytes),
+        -static_cast<int64_t>(p.io.readBytes), p.cmdline, p.tcomm);
+}
 
-    // Processes with the longest utime + stime are ranked first.
-    // Tie breaking is done with cmdline then tcomm.
-    bool operator<(const ProcStatEntry& other) const
+static std::string fullCmdline(const ProcessInfo& proc)
+{
+    std::string ret = proc.cmdline;
+    if (proc.tcomm.size() > 0)
     {
-        const float negTime = -(utime + stime);
-        const float negOtherTime = -(other.utime + other.stime);
-        return std::tie(negTime, cmdline, tcomm) <
-               std::tie(negOtherTime, other.cmdline, other.tcomm);
+        ret += " ";
+        ret += proc.tcomm;
     }
+    return ret;
+}
+
+// Columnar forms of the procstat and fdstat sections. Like the rows, they are
+// encoded by callbacks and must outlive the encoding.
+struct ProcStatColumns
+{
+    std::vector<int32_t> sidxDeltas;
+    std::vector<uint64_t> utimeTicks;
+    std::vector<uint64_t> stimeTicks;
+    std::vector<float> cpuPercent;
+    std::vector<float> cpuDelay;
+    std::vector<float> blkioDelay;
+    std::vector<float> swapinDelay;
+};
+
+struct FdStatColumns
+{
+    std::vector<int32_t> sidxDeltas;
+    std::vector<uint32_t> fdCount;
 };
 
+// Appends the string table index of each row as the difference from the
+// previous one, which fits in one byte when they were handed out in order.
+template <typename Row>
+static void appendSidxDeltas(const std::vector<Row>& rows,
+                             std::vector<int32_t>& deltas)
+{
+    int32_t previous = 0;
+    for (const Row& row : rows)
+    {
+        deltas.push_back(row.sidx_cmdline - previous);
+        previous = row.sidx_cmdline;
+    }
+}
+
 static bmcmetrics_metricproto_BmcProcStatMetric getProcStatMetric(
-    BmcHealthSnapshot& obj, long ticksPerSec,
+    StringPool& strings, long ticksPerSec, size_t topN,
+    const std::vector<ProcessInfo>& processes, float cpuInterval,
     std::vector<bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat>& procs,
-    bool& use) noexcept
+    ProcStatColumns* columns, bool& use) noexcept
 {
     if (ticksPerSec == 0)
     {
         return {};
     }
-    constexpr std::string_view procPath = "/proc/";
 
-    std::vector<ProcStatEntry> entries;
+    size_t othersCount = 0;
+    float othersUtime = 0;
+    float othersStime = 0;
+    uint64_t othersUtimeTicks = 0;
+    uint64_t othersStimeTicks = 0;
+    float othersPercent = 0;
+    bool othersHaveDelays = false;
+    float othersCpuDelay = 0;
+    float othersBlkioDelay = 0;
+    float othersSwapinDelay = 0;
+    const bool hasPercent = cpuInterval > 0;
+
+    // Only show the top processes and aggregate all remaining ones into
+    // "others" in order to keep the size of the snapshot reasonably small.
+    // With 10 process stat entries and 10 FD count entries, the size of the
+    // snapshot reaches around 1.5KiB.
+    auto fold = [&](const ProcessInfo& entry) {
+        ++othersCount;
+        othersUtime += entry.utime;
+        othersStime += entry.stime;
+        othersUtimeTicks += entry.utimeTicks;
+        othersStimeTicks += entry.stimeTicks;
+        othersPercent += std::max(entry.cpuPercent, 0.0f);
+        othersHaveDelays |= entry.hasDelays;
+        othersCpuDelay += entry.cpuDelay;
+        othersBlkioDelay += entry.blkioDelay;
+        othersSwapinDelay += entry.swapinDelay;
+    };
+    auto top = makeTopK<ProcessInfo>(topN, procStatKey, fold);
+    for (const ProcessInfo& proc : processes)
+    {
+        top.add(proc);
+    }
 
-    for (const auto& procEntry : std::filesystem::directory_iterator(procPath))
+    for (const ProcessInfo* entry : top.take())
     {
-        const std::string& path = procEntry.path();
-        int pid = -1;
-        if (isNumericPath(path, pid))
+        procs.emplace_back(bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat{
+            .sidx_cmdline = strings.getStringID(fullCmdline(*entry)),
+            .utime = entry->utime,
+            .stime = entry->stime,
+            .has_cpu_percent = hasPercent,
+            .cpu_percent = std::max(entry->cpuPercent, 0.0f),
+            .has_cpu_delay = entry->hasDelays,
+            .cpu_delay = entry->cpuDelay,
+            .has_blkio_delay = entry->hasDelays,
+            .blkio_delay = entry->blkioDelay,
+            .has_swapin_delay = entry->hasDelays,
+            .swapin_delay = entry->swapinDelay,
+        });
+        if (columns)
         {
-            ProcStatEntry entry;
-
-            try
-            {
-                entry.cmdline = getCmdLine(pid);
-                TcommUtimeStime t = getTcommUtimeStime(pid, ticksPerSec);
-                entry.tcomm = t.tcomm;
-                entry.utime = t.utime;
-                entry.stime = t.stime;
-
-                entries.push_back(entry);
-            }
-            catch (const std::exception& e)
-            {
-                log<level::ERR>("Could not obtain process stats");
-            }
+            columns->utimeTicks.push_back(entry->utimeTicks);
+            columns->stimeTicks.push_back(entry->stimeTicks);
         }
     }
 
-    std::sort(entries.begin(), entries.end());
-
-    bool isOthers = false;
-    ProcStatEntry others;
-    others.cmdline = "(Others)";
-    others.utime = others.stime = 0;
-
-    // Only show this many processes and aggregate all remaining ones into
-    // "others" in order to keep the size of the snapshot reasonably small.
-    // With 10 process stat entries and 10 FD count entries, the size of the
-    // snapshot reaches around 1.5KiB. This is non-trivial, and we have to set
-    // the collection interval long enough so as not to over-stress the IPMI
-    // interface and the data collection service. The value of 10 is chosen
-    // empirically, it might be subject to adjustments when the system is
-    // launched later.
-    constexpr int topN = 10;
-
-    for (size_t i = 0; i < entries.size(); ++i)
+    if (othersCount > 0)
     {
-        if (i >= topN)
+        procs.emplace_back(bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat{
+            .sidx_cmdline = strings.getStringID("(Others)"),
+            .utime = othersUtime,
+            .stime = othersStime,
+            .has_cpu_percent = hasPercent,
+            .cpu_percent = othersPercent,
+            .has_cpu_delay = othersHaveDelays,
+            .cpu_delay = othersCpuDelay,
+            .has_blkio_delay = othersHaveDelays,
+            .blkio_delay = othersBlkioDelay,
+            .has_swapin_delay = othersHaveDelays,
+            .swapin_delay = othersSwapinDelay,
+        });
+        if (columns)
         {
-            isOthers = true;
+            columns->utimeTicks.push_back(othersUtimeTicks);
+            columns->stimeTicks.push_back(othersStimeTicks);
         }
+    }
 
-        const ProcStatEntry& entry = entries[i];
+    use = true;
+    bmcmetrics_metricproto_BmcProcStatMetric metric = {};
+    metric.has_cpu_interval_sec = hasPercent;
+    metric.cpu_interval_sec = cpuInterval;
+    if (!columns)
+    {
+        metric.stats = pbSubsEncoder<
+            bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat_fields>(procs);
+        return metric;
+    }
 
-        if (isOthers)
+    // The columns drop the per-entry tag and length, and times are sent as
+    // the tick counts they are read as, which take 2 or 3 bytes as varints
+    // instead of 4 as floats.
+    appendSidxDeltas(procs, columns->sidxDeltas);
+    bool hasDelays = false;
+    for (const auto& proc : procs)
+    {
+        if (hasPercent)
         {
-            others.utime += entry.utime;
-            others.stime += entry.stime;
+            columns->cpuPercent.push_back(proc.cpu_percent);
         }
-        else
+        hasDelays |= proc.has_cpu_delay;
+        columns->cpuDelay.push_back(proc.cpu_delay);
+        columns->blkioDelay.push_back(proc.blkio_delay);
+        columns->swapinDelay.push_back(proc.swapin_delay);
+    }
+    if (!hasDelays)
+    {
+        columns->cpuDelay.clear();
+        columns->blkioDelay.clear();
+        columns->swapinDelay.clear();
+    }
+    metric.sidx_cmdline_delta = pbPackedEncoder(columns->sidxDeltas);
+    metric.utime_ticks = pbPackedEncoder(columns->utimeTicks);
+    metric.stime_ticks = pbPackedEncoder(columns->stimeTicks);
+    metric.has_ticks_per_sec = true;
+    metric.ticks_per_sec = static_cast<uint32_t>(ticksPerSec);
+    metric.cpu_percent = pbPackedEncoder(columns->cpuPercent);
+    metric.cpu_delay = pbPackedEncoder(columns->cpuDelay);
+    metric.blkio_delay = pbPackedEncoder(columns->blkioDelay);
+    metric.swapin_delay = pbPackedEncoder(columns->swapinDelay);
+    return metric;
+}
+
+static bmcmetrics_metricproto_BmcFdStatMetric getFdStatMetric(
+    StringPool& strings, long ticksPerSec, size_t topN,
+    const std::vector<ProcessInfo>& processes,
+    std::vector<bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat>& fds,
+    FdStatColumns* columns, bool& use) noexcept
+{
+    if (ticksPerSec == 0)
+    {
+        return {};
+    }
+
+    // Only report the detailed fd count and cmdline for the top entries,
+    // and collapse all others into "others".
+    size_t othersCount = 0;
+    int othersFdCount = 0;
+    auto fold = [&](const ProcessInfo& entry) {
+        ++othersCount;
+        othersFdCount += entry.fdCount;
+    };
+    auto top = makeTopK<ProcessInfo>(topN, fdStatKey, fold);
+    for (const ProcessInfo& proc : processes)
+    {
+        if (proc.fdCount >= 0)
         {
-            std::string fullCmdline = entry.cmdline;
-            if (entry.tcomm.size() > 0)
-            {
-                fullCmdline += " ";
-                fullCmdline += entry.tcomm;
-            }
-            procs.emplace_back(
-                bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat{
-                    .sidx_cmdline = obj.getStringID(fullCmdline),
-                    .utime = entry.utime,
-                    .stime = entry.stime,
-                });
+            top.add(proc);
         }
     }
 
-    if (isOthers)
+    for (const ProcessInfo* entry : top.take())
     {
-        procs.emplace_back(bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat{
-            .sidx_cmdline = obj.getStringID(others.cmdline),
-            .utime = others.utime,
-            .stime = others.stime,
+        fds.emplace_back(bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat{
+            .sidx_cmdline = strings.getStringID(fullCmdline(*entry)),
+            .fd_count = entry->fdCount,
+        });
+    }
 
+    if (othersCount > 0)
+    {
+        fds.emplace_back(bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat{
+            .sidx_cmdline = strings.getStringID("(Others)"),
+            .fd_count = othersFdCount,
         });
     }
 
     use = true;
-    return bmcmetrics_metricproto_BmcProcStatMetric{
-        .stats = pbSubsEncoder<
-            bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat_fields>(procs),
-    };
-}
-
-int getFdCount(int pid)
-{
-    const std::string& fdPath = "/proc/" + std::to_string(pid) + "/fd";
-    return std::distance(std::filesystem::directory_iterator(fdPath),
-                         std::filesystem::directory_iterator{});
-}
-
-struct FdStatEntry
-{
-    int fdCount;
-    std::string cmdline;
-    std::string tcomm;
-
-    // Processes with the largest fdCount goes first.
-    // Tie-breaking using cmdline then tcomm.
-    bool operator<(const FdStatEntry& other) const
+    bmcmetrics_metricproto_BmcFdStatMetric metric = {};
+    if (!columns)
     {
-        const int negFdCount = -fdCount;
-        const int negOtherFdCount = -other.fdCount;
-        return std::tie(negFdCount, cmdline, tcomm) <
-               std::tie(negOtherFdCount, other.cmdline, other.tcomm);
+        metric.stats = pbSubsEncoder<
+            bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat_fields>(fds);
+        return metric;
     }
-};
+    appendSidxDeltas(fds, columns->sidxDeltas);
+    for (const auto& fd : fds)
+    {
+        columns->fdCount.push_back(static_cast<uint32_t>(fd.fd_count));
+    }
+    metric.sidx_cmdline_delta = pbPackedEncoder(columns->sidxDeltas);
+    metric.fd_count = pbPackedEncoder(columns->fdCount);
+    return metric;
+}
 
-static bmcmetrics_metricproto_BmcFdStatMetric getFdStatMetric(
-    BmcHealthSnapshot& obj, long ticksPerSec,
-    std::vector<bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat>& fds,
+static bmcmetrics_metricproto_BmcProcMemMetric getProcMemMetric(
+    StringPool& strings, ProcFileReader& reader, size_t topN,
+    const std::vector<ProcessInfo>& processes,
+    std::vector<bmcmetrics_metricproto_BmcProcMemMetric_BmcProcMem>& mems,
     bool& use) noexcept
 {
-    if (ticksPerSec == 0)
+    if (processes.empty())
     {
         return {};
     }
 
-    // Sort by fd count, no tie-breaking
-    std::vector<FdStatEntry> entries;
-
-    const std::string_view procPath = "/proc/";
-    for (const auto& procEntry : std::filesystem::directory_iterator(procPath))
+    size_t othersCount = 0;
+    uint64_t othersRssKib = 0;
+    auto fold = [&](const ProcessInfo& entry) {
+        ++othersCount;
+        othersRssKib += entry.rssKib;
+    };
+    auto top = makeTopK<ProcessInfo>(topN, procMemKey, fold);
+    for (const ProcessInfo& proc : processes)
     {
-        const std::string& path = procEntry.path();
-        int pid = 0;
-        FdStatEntry entry;
-        if (isNumericPath(path, pid))
-        {
-            try
-            {
-                entry.fdCount = getFdCount(pid);
-                TcommUtimeStime t = getTcommUtimeStime(pid, ticksPerSec);
-                entry.cmdline = getCmdLine(pid);
-                entry.tcomm = t.tcomm;
-                entries.push_back(entry);
-            }
-            catch (const std::exception& e)
-            {
-                log<level::ERR>("Could not get file descriptor stats");
-            }
-        }
+        top.add(proc);
     }
 
-    std::sort(entries.begin(), entries.end());
-
-    bool isOthers = false;
+    for (const ProcessInfo* entry : top.take())
+    {
+        // Computing PSS walks the page tables of the process, so it is only
+        // asked for the processes that are reported.
+        int pssKib = 0;
+        bool hasPss = parseMeminfoValue(reader.read(entry->pid, "smaps_rollup"),
+                                        "\nPss:", pssKib);
+        mems.emplace_back(bmcmetrics_metricproto_BmcProcMemMetric_BmcProcMem{
+            .sidx_cmdline = strings.getStringID(fullCmdline(*entry)),
+            .rss_kib = static_cast<int32_t>(entry->rssKib),
+            .has_pss_kib = hasPss,
+            .pss_kib = pssKib,
+        });
+    }
 
-    // Only report the detailed fd count and cmdline for the top 10 entries,
-    // and collapse all others into "others".
-    constexpr int topN = 10;
+    if (othersCount > 0)
+    {
+        mems.emplace_back(bmcmetrics_metricproto_BmcProcMemMetric_BmcProcMem{
+            .sidx_cmdline = strings.getStringID("(Others)"),
+            .rss_kib = static_cast<int32_t>(othersRssKib),
+            .has_pss_kib = false,
+            .pss_kib = 0,
+        });
+    }
 
-    FdStatEntry others;
-    others.cmdline = "(Others)";
-    others.fdCount = 0;
+    use = true;
+    return bmcmetrics_metricproto_BmcProcMemMetric{
+        .stats = pbSubsEncoder<
+            bmcmetrics_metricproto_BmcProcMemMetric_BmcProcMem_fields>(mems),
+    };
+}
 
-    for (size_t i = 0; i < entries.size(); ++i)
+static bmcmetrics_metricproto_BmcProcIoMetric getProcIoMetric(
+    StringPool& strings, size_t topN, const std::vector<ProcessInfo>& processes,
+    float interval,
+    std::vector<bmcmetrics_metricproto_BmcProcIoMetric_BmcProcIo>& ios,
+    bool& use) noexcept
+{
+    size_t othersCount = 0;
+    uint64_t othersReadBytes = 0;
+    uint64_t othersWriteBytes = 0;
+    float othersWriteRate = 0;
+    const bool hasRate = interval > 0;
+    auto fold = [&](const ProcessInfo& entry) {
+        ++othersCount;
+        othersReadBytes += entry.io.readBytes;
+        othersWriteBytes += entry.io.writeBytes;
+        othersWriteRate += std::max(entry.writeBytesPerSec, 0.0f);
+    };
+    auto top = makeTopK<ProcessInfo>(topN, procIoKey, fold);
+    bool hasIo = false;
+    for (const ProcessInfo& proc : processes)
     {
-        if (i >= topN)
+        if (proc.hasIo)
         {
-            isOthers = true;
+            top.add(proc);
+            hasIo = true;
         }
+    }
+    // No process had readable I/O accounting, e.g. a kernel built without
+    // CONFIG_TASK_IO_ACCOUNTING.
+    if (!hasIo)
+    {
+        return {};
+    }
 
-        const FdStatEntry& entry = entries[i];
-        if (isOthers)
-        {
-            others.fdCount += entry.fdCount;
-        }
-        else
-        {
-            std::string fullCmdline = entry.cmdline;
-            if (entry.tcomm.size() > 0)
-            {
-                fullCmdline += " ";
-                fullCmdline += entry.tcomm;
-            }
-            fds.emplace_back(bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat{
-                .sidx_cmdline = obj.getStringID(fullCmdline),
-                .fd_count = entry.fdCount,
-            });
-        }
+    for (const ProcessInfo* entry : top.take())
+    {
+        ios.emplace_back(bmcmetrics_metricproto_BmcProcIoMetric_BmcProcIo{
+            .sidx_cmdline = strings.getStringID(fullCmdline(*entry)),
+            .read_bytes = entry->io.readBytes,
+            .write_bytes = entry->io.writeBytes,
+            .has_write_bytes_per_sec = hasRate,
+            .write_bytes_per_sec = std::max(entry->writeBytesPerSec, 0.0f),
+        });
     }
 
-    if (isOthers)
+    if (othersCount > 0)
     {
-        fds.emplace_back(bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat{
-            .sidx_cmdline = obj.getStringID(others.cmdline),
-            .fd_count = others.fdCount,
+        ios.emplace_back(bmcmetrics_metricproto_BmcProcIoMetric_BmcProcIo{
+            .sidx_cmdline = strings.getStringID("(Others)"),
+            .read_bytes = othersReadBytes,
+            .write_bytes = othersWriteBytes,
+            .has_write_bytes_per_sec = hasRate,
+            .write_bytes_per_sec = othersWriteRate,
         });
     }
 
     use = true;
-    return bmcmetrics_metricproto_BmcFdStatMetric{
+    return bmcmetrics_metricproto_BmcProcIoMetric{
         .stats = pbSubsEncoder<
-            bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat_fields>(fds),
+            bmcmetrics_metricproto_BmcProcIoMetric_BmcProcIo_fields>(ios),
+        .has_interval_sec = hasRate,
+        .interval_sec = interval,
     };
 }
 
-static bmcmetrics_metricproto_BmcECCMetric getECCMetric(bool& use) noexcept
+static bmcmetrics_metricproto_BmcECCMetric getECCMetric(EdacCounters& edac,
+                                                        BusMetrics& bus,
+                                                        bool& use) noexcept
 {
+    // The ECC daemon only republishes the EDAC counts, so only ask it when
+    // they cannot be read directly.
     EccCounts eccCounts;
-    use = getECCErrorCounts(eccCounts);
+    use = edac.read(eccCounts) || bus.getEccCounts(eccCounts);
     if (!use)
     {
         return {};
@@ -329,10 +461,11 @@ static bmcmetrics_metricproto_BmcECCMetric getECCMetric(bool& use) noexcept
     };
 }
 
-static bmcmetrics_metricproto_BmcMemoryMetric getMemMetric() noexcept
+static bmcmetrics_metricproto_BmcMemoryMetric getMemMetric(
+    ProcFileReader& reader) noexcept
 {
     bmcmetrics_metricproto_BmcMemoryMetric ret = {};
-    auto data = readFileThenGrepIntoString("/proc/meminfo");
+    std::string_view data = reader.read("/proc/meminfo");
     int value;
     if (parseMeminfoValue(data, "MemAvailable:", value))
     {
@@ -351,13 +484,13 @@ static bmcmetrics_metricproto_BmcMemoryMetric getMemMetric() noexcept
 }
 
 static bmcmetrics_metricproto_BmcUptimeMetric getUptimeMetric(
-    bool& use) noexcept
+    ProcFileReader& reader, BusMetrics& bus, bool& use) noexcept
 {
     bmcmetrics_metricproto_BmcUptimeMetric ret = {};
 
     double uptime = 0;
     {
-        auto data = readFileThenGrepIntoString("/proc/uptime");
+        std::string_view data = reader.read("/proc/uptime");
         double idleProcessTime = 0;
         if (!parseProcUptime(data, uptime, idleProcessTime))
         {
@@ -368,41 +501,154 @@ static bmcmetrics_metricproto_BmcUptimeMetric getUptimeMetric(
         ret.idle_process_time = idleProcessTime;
     }
 
-    BootTimesMonotonic btm;
-    if (!getBootTimesMonotonic(btm))
+    BootDurations boot;
+    if (!bus.getBootDurations(uptime, boot))
     {
         log<level::ERR>("Could not get boot time");
         return ret;
     }
-    if (btm.firmwareTime == 0 && btm.powerOnSecCounterTime != 0)
+    ret.firmware_boot_time_sec = boot.firmwareSec;
+    ret.loader_boot_time_sec = boot.loaderSec;
+    ret.kernel_boot_time_sec = boot.kernelSec;
+    ret.initrd_boot_time_sec = boot.initrdSec;
+    ret.userspace_boot_time_sec = boot.userspaceSec;
+
+    use = true;
+    return ret;
+}
+
+static bmcmetrics_metricproto_BmcPressureMetric_Stall toStallMetric(
+    const PressureStall& stall) noexcept
+{
+    return bmcmetrics_metricproto_BmcPressureMetric_Stall{
+        .avg10 = stall.avg10,
+        .avg60 = stall.avg60,
+        .avg300 = stall.avg300,
+        .total_us = stall.total,
+    };
+}
+
+// Reads one /proc/pressure file. Returns false if the kernel does not
+// provide it, e.g. when built without CONFIG_PSI or booted with psi=0.
+static bool getPressureResource(
+    ProcFileReader& reader, const char* path,
+    bmcmetrics_metricproto_BmcPressureMetric_Resource& ret) noexcept
+{
+    Pressure pressure;
+    if (!parsePressure(reader.read(path), pressure))
     {
-        ret.firmware_boot_time_sec =
-            static_cast<double>(btm.powerOnSecCounterTime) - uptime;
+        return false;
     }
-    else
+    ret = bmcmetrics_metricproto_BmcPressureMetric_Resource{
+        .has_some = true,
+        .some = toStallMetric(pressure.some),
+        .has_full = pressure.hasFull,
+        .full = toStallMetric(pressure.full),
+    };
+    return true;
+}
+
+static bmcmetrics_metricproto_BmcPressureMetric getPressureMetric(
+    ProcFileReader& reader, bool& use) noexcept
+{
+    bmcmetrics_metricproto_BmcPressureMetric ret = {};
+    ret.has_cpu = getPressureResource(reader, "/proc/pressure/cpu", ret.cpu);
+    ret.has_memory =
+        getPressureResource(reader, "/proc/pressure/memory", ret.memory);
+    ret.has_io = getPressureResource(reader, "/proc/pressure/io", ret.io);
+    use = ret.has_cpu || ret.has_memory || ret.has_io;
+    return ret;
+}
+
+static bmcmetrics_metricproto_BmcNetDevMetric getNetDevMetric(
+    StringPool& strings, ProcFileReader& reader, NetDevRateTracker& tracker,
+    std::vector<bmcmetrics_metricproto_BmcNetDevMetric_BmcNetDev>& ifaces,
+    bool& use) noexcept
+{
+    std::vector<NetDevInfo> netDevs = collectNetDevs(reader);
+    if (netDevs.empty())
     {
-        ret.firmware_boot_time_sec =
-            static_cast<double>(btm.firmwareTime - btm.loaderTime) / 1e6;
+        log<level::ERR>("Could not read /proc/net/dev");
+        return {};
     }
-    ret.loader_boot_time_sec = static_cast<double>(btm.loaderTime) / 1e6;
-    if (btm.initrdTime != 0)
+    const float interval =
+        tracker.update(netDevs, std::chrono::steady_clock::now());
+    const bool hasRate = interval > 0;
+
+    for (const NetDevInfo& dev : netDevs)
     {
-        ret.kernel_boot_time_sec = static_cast<double>(btm.initrdTime) / 1e6;
-        ret.initrd_boot_time_sec =
-            static_cast<double>(btm.userspaceTime - btm.initrdTime) / 1e6;
-        ret.userspace_boot_time_sec =
-            static_cast<double>(btm.finishTime - btm.userspaceTime) / 1e6;
+        const NetDevCounters& c = dev.counters;
+        ifaces.emplace_back(bmcmetrics_metricproto_BmcNetDevMetric_BmcNetDev{
+            .sidx_name = strings.getStringID(dev.name),
+            .rx_bytes = c.rxBytes,
+            .rx_packets = c.rxPackets,
+            .rx_errors = c.rxErrors,
+            .rx_drops = c.rxDrops,
+            .tx_bytes = c.txBytes,
+            .tx_packets = c.txPackets,
+            .tx_errors = c.txErrors,
+            .tx_drops = c.txDrops,
+            .has_rx_bytes_per_sec = hasRate,
+            .rx_bytes_per_sec = dev.rxBytesPerSec,
+            .has_tx_bytes_per_sec = hasRate,
+            .tx_bytes_per_sec = dev.txBytesPerSec,
+            .has_rx_packets_per_sec = hasRate,
+            .rx_packets_per_sec = dev.rxPacketsPerSec,
+            .has_tx_packets_per_sec = hasRate,
+            .tx_packets_per_sec = dev.txPacketsPerSec,
+        });
     }
-    else
+
+    use = true;
+    return bmcmetrics_metricproto_BmcNetDevMetric{
+        .interfaces = pbSubsEncoder<
+            bmcmetrics_metricproto_BmcNetDevMetric_BmcNetDev_fields>(ifaces),
+        .has_interval_sec = hasRate,
+        .interval_sec = interval,
+    };
+}
+
+static bmcmetrics_metricproto_BmcCpuMetric getCpuMetric(
+    ProcFileReader& reader, CpuStatTracker& tracker,
+    std::vector<bmcmetrics_metricproto_BmcCpuMetric_BmcCpuUsage>& usages,
+    bool& use) noexcept
+{
+    std::vector<CpuStat> cpus = collectCpuStats(reader);
+    if (cpus.empty())
     {
-        ret.kernel_boot_time_sec = static_cast<double>(btm.userspaceTime) / 1e6;
-        ret.initrd_boot_time_sec = 0;
-        ret.userspace_boot_time_sec =
-            static_cast<double>(btm.finishTime - btm.userspaceTime) / 1e6;
+        log<level::ERR>("Could not read /proc/stat");
+        return {};
+    }
+    const float interval =
+        tracker.update(cpus, std::chrono::steady_clock::now());
+    if (interval <= 0)
+    {
+        return {};
     }
 
-    use = true;
-    return ret;
+    for (const CpuStat& stat : cpus)
+    {
+        if (stat.userPercent < 0)
+        {
+            continue;
+        }
+        usages.emplace_back(bmcmetrics_metricproto_BmcCpuMetric_BmcCpuUsage{
+            .cpu = stat.cpu,
+            .user_percent = stat.userPercent,
+            .system_percent = stat.systemPercent,
+            .iowait_percent = stat.iowaitPercent,
+            .irq_percent = stat.irqPercent,
+            .softirq_percent = stat.softirqPercent,
+            .steal_percent = stat.stealPercent,
+        });
+    }
+
+    use = !usages.empty();
+    return bmcmetrics_metricproto_BmcCpuMetric{
+        .cpus = pbSubsEncoder<
+            bmcmetrics_metricproto_BmcCpuMetric_BmcCpuUsage_fields>(usages),
+        .interval_sec = interval,
+    };
 }
 
 static bmcmetrics_metricproto_BmcDiskSpaceMetric getStorageMetric(
@@ -432,87 +678,210 @@ static bmcmetrics_metricproto_BmcDiskSpaceMetric getStorageMetric(
     return ret;
 }
 
-void BmcHealthSnapshot::doWork()
+// Summarizes a collected snapshot into a record for the history.
+static HistoryRecord getHistoryRecord(
+    const bmcmetrics_metricproto_BmcMetricSnapshot& snapshot,
+    const std::vector<bmcmetrics_metricproto_BmcCpuMetric_BmcCpuUsage>& usages,
+    const std::vector<ProcessInfo>& processes) noexcept
 {
+    HistoryRecord record;
+    if (snapshot.has_uptime_metric)
+    {
+        record.uptime = snapshot.uptime_metric.uptime;
+    }
+    if (snapshot.has_memory_metric)
+    {
+        record.memAvailableKib = snapshot.memory_metric.mem_available;
+    }
+    // The aggregate of all CPUs comes first.
+    if (!usages.empty() && usages.front().cpu < 0)
+    {
+        const auto& all = usages.front();
+        record.cpuBusyPercent = all.user_percent + all.system_percent +
+                                all.irq_percent + all.softirq_percent +
+                                all.steal_percent;
+        record.cpuIowaitPercent = all.iowait_percent;
+    }
+    if (snapshot.has_pressure_metric)
+    {
+        auto some = [](bool has, const auto& resource) {
+            return has && resource.has_some ? resource.some.avg10 : -1.0f;
+        };
+        auto full = [](bool has, const auto& resource) {
+            return has && resource.has_full ? resource.full.avg10 : -1.0f;
+        };
+        const auto& psi = snapshot.pressure_metric;
+        record.cpuSomeAvg10 = some(psi.has_cpu, psi.cpu);
+        record.memorySomeAvg10 = some(psi.has_memory, psi.memory);
+        record.memoryFullAvg10 = full(psi.has_memory, psi.memory);
+        record.ioSomeAvg10 = some(psi.has_io, psi.io);
+        record.ioFullAvg10 = full(psi.has_io, psi.io);
+    }
+
+    auto top = makeTopK<ProcessInfo>(HistoryRecord::maxProcesses, procStatKey,
+                                     [](const ProcessInfo&) {});
+    for (const ProcessInfo& proc : processes)
+    {
+        top.add(proc);
+    }
+    for (const ProcessInfo* proc : top.take())
+    {
+        HistoryRecord::Process& entry = record.processes[record.numProcesses++];
+        // tcomm is "(comm)"; keep what is between the parentheses.
+        std::string_view comm = proc->tcomm;
+        if (comm.size() >= 2)
+        {
+            comm = comm.substr(1, comm.size() - 2);
+        }
+        comm = comm.substr(0, entry.comm.size() - 1);
+        std::copy(comm.begin(), comm.end(), entry.comm.begin());
+        entry.cpuPercent = proc->cpuPercent;
+        entry.rssKib = static_cast<uint32_t>(proc->rssKib);
+    }
+    return record;
+}
+
+bool BmcHealthSnapshot::doWork(CollectionState& state)
+{
+    auto want = [this](uint32_t s) { return (sections & s) != 0; };
+    RateTrackers& rates = state.ratesFor(sections);
+
     // The next metrics require a sane ticks_per_sec value, typically 100 on
     // the BMC. In the very rare circumstance when it's 0, exit early and return
     // a partially complete snapshot (no process).
     ticksPerSec = getTicksPerSec();
 
+    // Every procfs file of this snapshot is read through the same buffer.
+    ProcFileReader reader;
+
+    // Walk /proc only once; all per-process sections are built from the
+    // same process table. Skip it entirely if none of them was asked for.
+    std::vector<ProcessInfo> processes;
+    float interval = 0;
+    if (ticksPerSec != 0 && want(section::processes))
+    {
+        processes = collectProcesses(
+            reader, ticksPerSec,
+            {
+                .countFds = want(section::fdstat),
+                .table = state.processTable.get(),
+                .taskstats = state.taskstats.get(),
+                .files = &state.files,
+            });
+        interval = rates.processes.update(processes, ticksPerSec,
+                                          std::chrono::steady_clock::now());
+    }
+
+    // Indices handed out from here on refer to this snapshot's string table.
+    state.strings.beginSnapshot();
+
     static constexpr auto stcb = [](pb_ostream_t* stream,
                                     const pb_field_t* field,
                                     void* const* arg) noexcept {
-        auto& self = *reinterpret_cast<BmcHealthSnapshot*>(*arg);
-        std::vector<std::string_view> strs(self.stringTable.size());
-        for (const auto& [str, i] : self.stringTable)
-        {
-            strs[i] = str;
-        }
-        for (auto& str : strs)
-        {
-            bmcmetrics_metricproto_BmcStringTable_StringEntry msg = {
-                .value = pbStrEncoder(str),
-            };
-            if (!pb_encode_tag_for_field(stream, field) ||
-                !pb_encode_submessage(
-                    stream,
-                    bmcmetrics_metricproto_BmcStringTable_StringEntry_fields,
-                    &msg))
-            {
-                return false;
-            }
-        }
-        return true;
+        const auto& strings = *reinterpret_cast<const StringPool*>(*arg);
+        return pbEncodeStringEntries(stream, field, strings.strings());
     };
     std::vector<bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat> procs;
     std::vector<bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat> fds;
-    bmcmetrics_metricproto_BmcMetricSnapshot snapshot = {
-        .has_string_table = true,
-        .string_table =
-            {
-                .entries = {{.encode = stcb}, this},
-            },
-        .has_memory_metric = true,
-        .memory_metric = getMemMetric(),
-        .has_uptime_metric = false,
-        .uptime_metric = getUptimeMetric(snapshot.has_uptime_metric),
-        .has_storage_space_metric = false,
-        .storage_space_metric =
-            getStorageMetric(snapshot.has_storage_space_metric),
-        .has_procstat_metric = false,
-        .procstat_metric = getProcStatMetric(*this, ticksPerSec, procs,
-                                             snapshot.has_procstat_metric),
-        .has_fdstat_metric = false,
-        .fdstat_metric = getFdStatMetric(*this, ticksPerSec, fds,
-                                         snapshot.has_fdstat_metric),
-        .has_ecc_metric = false,
-        .ecc_metric = getECCMetric(snapshot.has_ecc_metric),
-    };
-    pb_ostream_t nost = {};
-    if (!pb_encode(&nost, bmcmetrics_metricproto_BmcMetricSnapshot_fields,
-                   &snapshot))
+    ProcStatColumns procColumns;
+    FdStatColumns fdColumns;
+    const bool columnar = want(section::columnar);
+    std::vector<bmcmetrics_metricproto_BmcProcMemMetric_BmcProcMem> mems;
+    std::vector<bmcmetrics_metricproto_BmcProcIoMetric_BmcProcIo> ios;
+    std::vector<bmcmetrics_metricproto_BmcNetDevMetric_BmcNetDev> ifaces;
+    std::vector<bmcmetrics_metricproto_BmcCpuMetric_BmcCpuUsage> usages;
+    bmcmetrics_metricproto_BmcMetricSnapshot snapshot = {};
+    snapshot.has_string_table = true;
+    snapshot.string_table.entries = {{.encode = stcb}, &state.strings};
+    if (want(section::memory))
     {
-        auto msg = std::format("Getting pb size: {}", PB_GET_ERROR(&nost));
-        log<level::ERR>(msg.c_str());
-        return;
+        snapshot.has_memory_metric = true;
+        snapshot.memory_metric = getMemMetric(reader);
+    }
+    if (want(section::uptime))
+    {
+        snapshot.uptime_metric =
+            getUptimeMetric(reader, state.bus, snapshot.has_uptime_metric);
+    }
+    if (want(section::storage))
+    {
+        snapshot.storage_space_metric =
+            getStorageMetric(snapshot.has_storage_space_metric);
+    }
+    if (want(section::procstat))
+    {
+        snapshot.procstat_metric = getProcStatMetric(
+            state.strings, ticksPerSec, state.topN, processes, interval, procs,
+            columnar ? &procColumns : nullptr, snapshot.has_procstat_metric);
+    }
+    if (want(section::fdstat))
+    {
+        snapshot.fdstat_metric =
+            getFdStatMetric(state.strings, ticksPerSec, state.topN, processes,
+                            fds, columnar ? &fdColumns : nullptr,
+                            snapshot.has_fdstat_metric);
+    }
+    if (want(section::ecc))
+    {
+        snapshot.ecc_metric = getECCMetric(state.edac, state.bus,
+                                           snapshot.has_ecc_metric);
+    }
+    if (want(section::procmem))
+    {
+        snapshot.procmem_metric =
+            getProcMemMetric(state.strings, reader, state.topN, processes,
+                             mems, snapshot.has_procmem_metric);
+    }
+    if (want(section::procio))
+    {
+        snapshot.procio_metric =
+            getProcIoMetric(state.strings, state.topN, processes, interval,
+                            ios, snapshot.has_procio_metric);
     }
-    pbDump.resize(nost.bytes_written);
-    auto ost = pb_ostream_from_buffer(
-        reinterpret_cast<pb_byte_t*>(pbDump.data()), pbDump.size());
-    if (!pb_encode(&ost, bmcmetrics_metricproto_BmcMetricSnapshot_fields,
-                   &snapshot))
+    if (want(section::pressure))
     {
-        auto msg = std::format("Writing pb msg: {}", PB_GET_ERROR(&ost));
+        snapshot.pressure_metric =
+            getPressureMetric(reader, snapshot.has_pressure_metric);
+    }
+    if (want(section::netdev))
+    {
+        snapshot.netdev_metric =
+            getNetDevMetric(state.strings, reader, rates.netDevs, ifaces,
+                            snapshot.has_netdev_metric);
+    }
+    if (want(section::cpu))
+    {
+        snapshot.cpu_metric = getCpuMetric(reader, rates.cpus, usages,
+                                           snapshot.has_cpu_metric);
+    }
+
+    const char* error = nullptr;
+    if (!encodeSnapshot(snapshot, pbDump, error))
+    {
+        auto msg = std::format("Writing pb msg: {}", error);
         log<level::ERR>(msg.c_str());
-        return;
+        failed = true;
+        return false;
+    }
+    pbDump.shrink_to_fit();
+    // Only complete snapshots are summarized, so that every record of the
+    // history has every field it can have.
+    if (sections == section::all)
+    {
+        state.record = getHistoryRecord(snapshot, usages, processes);
     }
     done = true;
+    return true;
 }
 
 // BmcBlobSessionStat (9) but passing meta as reference instead of pointer,
 // since the metadata must not be null at this point.
-bool BmcHealthSnapshot::stat(blobs::BlobMeta& meta)
+bool BmcHealthSnapshot::stat(blobs::BlobMeta& meta) const
 {
+    if (failed)
+    {
+        return false;
+    }
     if (!done)
     {
         // Bits 8~15 are blob-specific state flags.
@@ -530,32 +899,14 @@ bool BmcHealthSnapshot::stat(blobs::BlobMeta& meta)
 }
 
 std::string_view BmcHealthSnapshot::read(uint32_t offset,
-                                         uint32_t requestedSize)
+                                         uint32_t requestedSize) const
 {
-    uint32_t size = static_cast<uint32_t>(pbDump.size());
-    if (offset >= size)
+    // pbDump is owned by the worker thread until done is set.
+    if (!done)
     {
         return {};
     }
-    return std::string_view(pbDump.data() + offset,
-                            std::min(requestedSize, size - offset));
-}
-
-int BmcHealthSnapshot::getStringID(const std::string_view s)
-{
-    int ret = 0;
-    auto itr = stringTable.find(s.data());
-    if (itr == stringTable.end())
-    {
-        stringTable[s.data()] = stringId;
-        ret = stringId;
-        ++stringId;
-    }
-    else
-    {
-        ret = itr->second;
-    }
-    return ret;
+    return readAt(pbDump, offset, requestedSize);
 }
 
 } // namespace metric_blob
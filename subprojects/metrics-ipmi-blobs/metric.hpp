@@ -13,11 +13,23 @@
 // limitations under the License.
 
 #pragma once
+#include "bus.hpp"
+#include "content.hpp"
+#include "cpu.hpp"
+#include "edac.hpp"
+#include "history.hpp"
+#include "net.hpp"
+#include "proc.hpp"
+#include "process_table.hpp"
+#include "string_pool.hpp"
+#include "taskstats.hpp"
+
 #include <blobs-ipmid/blobs.hpp>
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <string>
+#include <memory>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
@@ -25,46 +37,109 @@
 namespace metric_blob
 {
 
-class BmcHealthSnapshot
+/**
+ * Sections of a snapshot as a bitmask, so that a client can have only the
+ * sections it reads collected and sent.
+ */
+namespace section
 {
-  public:
-    BmcHealthSnapshot();
+constexpr uint32_t memory = 1 << 0;
+constexpr uint32_t uptime = 1 << 1;
+constexpr uint32_t storage = 1 << 2;
+constexpr uint32_t procstat = 1 << 3;
+constexpr uint32_t fdstat = 1 << 4;
+constexpr uint32_t ecc = 1 << 5;
+constexpr uint32_t procmem = 1 << 6;
+constexpr uint32_t procio = 1 << 7;
+constexpr uint32_t pressure = 1 << 8;
+constexpr uint32_t netdev = 1 << 9;
+constexpr uint32_t cpu = 1 << 10;
+constexpr uint32_t all = (1 << 11) - 1;
+// Sections built from the walk of /proc/<pid>.
+constexpr uint32_t processes = procstat | fdstat | procmem | procio;
+// Not a section: has procstat and fdstat encoded as packed columns.
+constexpr uint32_t columnar = 1u << 31;
+} // namespace section
 
-    /**
-     * Reads data from this metric
-     * @param offset: offset into the data to read
-     * @param requestedSize: how many bytes to read
-     * @returns Bytes able to read. Returns empty if nothing can be read.
-     */
-    std::string_view read(uint32_t offset, uint32_t requestedSize);
+/** Previous samples of the metrics reported as rates. */
+struct RateTrackers
+{
+    ProcessRateTracker processes;
+    NetDevRateTracker netDevs;
+    CpuStatTracker cpus;
+};
 
+/**
+ * State carried from one collection to the next, for the metrics that are
+ * reported as rates and for the strings that recur in every snapshot. Only
+ * the thread running doWork() touches it.
+ */
+struct CollectionState
+{
     /**
-     * Returns information about the amount of readable data and whether the
-     * metric has finished populating.
-     * @param meta: Struct to fill with the metadata info
+     * Rates are kept per sections bitmask, so that polling a section blob
+     * does not shorten the interval the rates of the other blobs cover.
+     * @returns The trackers of the snapshots that collect these sections.
      */
-    bool stat(blobs::BlobMeta& meta);
+    RateTrackers& ratesFor(uint32_t sections)
+    {
+        return rates[sections];
+    }
 
-    /**
-     * Start the metric collection process
-     */
-    void doWork();
+    std::unordered_map<uint32_t, RateTrackers> rates;
+    ProcFileCache files;
+    EdacCounters edac;
+    BusMetrics bus;
+    // Only set if process events are enabled.
+    std::unique_ptr<ProcessTable> processTable;
+    // Only set if collection through taskstats is enabled.
+    std::unique_ptr<TaskStatsClient> taskstats;
+    // Summary of the last complete snapshot, for the history.
+    HistoryRecord record;
+    StringPool strings;
+    // How many processes the per-process sections list before "(Others)".
+    size_t topN = 10;
+};
 
+/**
+ * One collected and encoded health snapshot. Once doWork() has completed, the
+ * object is immutable and is shared read-only by every blob session that was
+ * handed it; the collection-time state is released at that point so that only
+ * the encoded buffer stays resident.
+ */
+class BmcHealthSnapshot : public BlobContent
+{
+  public:
     /**
-     * The size of the content string.
+     * @param sections: bitmask of the sections to collect
      */
-    uint32_t size();
+    explicit BmcHealthSnapshot(uint32_t sections = section::all);
+    BmcHealthSnapshot(const BmcHealthSnapshot&) = delete;
+    BmcHealthSnapshot& operator=(const BmcHealthSnapshot&) = delete;
+
+    std::string_view read(uint32_t offset,
+                          uint32_t requestedSize) const override;
+    bool stat(blobs::BlobMeta& meta) const override;
 
     /**
-     * Returns the ID of the provided string
+     * Start the metric collection process. May run on a thread other than
+     * the one calling read() and stat(); those report nothing until it is
+     * done.
+     * @param state: state left by the previous collection, updated in place
+     * @returns true if the snapshot was collected and encoded
      */
-    int getStringID(const std::string_view s);
+    bool doWork(CollectionState& state);
+
+    uint32_t getSections() const
+    {
+        return sections;
+    }
 
   private:
     std::atomic<bool> done;
+    std::atomic<bool> failed;
     std::vector<char> pbDump;
-    std::unordered_map<std::string, int> stringTable;
-    int stringId;
+    const uint32_t sections;
     long ticksPerSec;
 };
 
@@ -0,0 +1,100 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "net.hpp"
+
+#include "util.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+std::vector<NetDevInfo> collectNetDevs(ProcFileReader& reader)
+{
+    std::vector<NetDevInfo> netDevs;
+    std::string_view content = reader.read("/proc/net/dev");
+    while (!content.empty())
+    {
+        size_t eol = content.find('\n');
+        std::string_view line = content.substr(0, eol);
+        content = eol == std::string_view::npos ? std::string_view()
+                                                : content.substr(eol + 1);
+
+        std::string_view name;
+        NetDevCounters counters;
+        if (parseNetDevLine(line, name, counters))
+        {
+            netDevs.push_back({std::string(name), counters});
+        }
+    }
+    return netDevs;
+}
+
+// Counters go back to zero when an interface is re-created, in which case
+// everything counted since then is new.
+static float rate(uint64_t current, uint64_t last, float interval)
+{
+    uint64_t delta = current >= last ? current - last : current;
+    return static_cast<float>(delta) / interval;
+}
+
+float NetDevRateTracker::update(std::vector<NetDevInfo>& netDevs,
+                                const std::chrono::steady_clock::time_point now)
+{
+    float interval = 0;
+    if (hasPrevious)
+    {
+        interval = std::chrono::duration<float>(now - previousTime).count();
+    }
+
+    for (NetDevInfo& dev : netDevs)
+    {
+        // An interface that appeared since last time counted from zero.
+        auto it = previous.find(std::string_view(dev.name));
+        if (it == previous.end())
+        {
+            it = previous.emplace(dev.name, Sample{}).first;
+        }
+        Sample& last = it->second;
+        const NetDevCounters& c = dev.counters;
+        if (interval > 0)
+        {
+            const NetDevCounters& l = last.counters;
+            dev.rxBytesPerSec = rate(c.rxBytes, l.rxBytes, interval);
+            dev.txBytesPerSec = rate(c.txBytes, l.txBytes, interval);
+            dev.rxPacketsPerSec = rate(c.rxPackets, l.rxPackets, interval);
+            dev.txPacketsPerSec = rate(c.txPackets, l.txPackets, interval);
+        }
+        last.counters = c;
+        last.generation = generation;
+    }
+
+    // Removed interfaces are dropped, so that they count from zero if they
+    // come back.
+    std::erase_if(previous, [this](const auto& entry) {
+        return entry.second.generation != generation;
+    });
+    ++generation;
+    previousTime = now;
+    hasPrevious = true;
+    return interval;
+}
+
+} // namespace metric_blob
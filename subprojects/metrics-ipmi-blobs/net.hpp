@@ -0,0 +1,95 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "util.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+/** Counters of one network interface and their rates. */
+struct NetDevInfo
+{
+    std::string name;
+    NetDevCounters counters;
+    // Per second since the previous snapshot. Negative if there is no
+    // previous snapshot to compare with.
+    float rxBytesPerSec = -1;
+    float txBytesPerSec = -1;
+    float rxPacketsPerSec = -1;
+    float txPacketsPerSec = -1;
+};
+
+/**
+ * Reads the counters of every network interface from a single read of
+ * /proc/net/dev.
+ * @param reader: reader whose buffer is used for the read
+ * @returns One entry per interface, in /proc/net/dev order.
+ */
+std::vector<NetDevInfo> collectNetDevs(ProcFileReader& reader);
+
+/**
+ * Remembers the counters of every interface between snapshots, so that a
+ * snapshot can report current throughput rather than totals since boot.
+ */
+class NetDevRateTracker
+{
+  public:
+    /**
+     * Sets the rates of every interface from its counters at the previous
+     * call, and remembers the current counters for the next one.
+     * @param netDevs: interfaces of the current snapshot
+     * @param now: when the counters were read
+     * @returns The interval in seconds the rates are computed over, or 0 on
+     *     the first call.
+     */
+    float update(std::vector<NetDevInfo>& netDevs,
+                 std::chrono::steady_clock::time_point now);
+
+  private:
+    // Lets names be looked up without building a string, so that only an
+    // interface that appeared allocates.
+    struct NameHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+    struct Sample
+    {
+        NetDevCounters counters;
+        // The call that last saw the interface.
+        uint32_t generation;
+    };
+
+    std::unordered_map<std::string, Sample, NameHash, std::equal_to<>>
+        previous;
+    std::chrono::steady_clock::time_point previousTime;
+    bool hasPrevious = false;
+    uint32_t generation = 0;
+};
+
+} // namespace metric_blob
@@ -0,0 +1,435 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proc.hpp"
+
+#include "util.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metric_blob
+{
+
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+ProcFileCache::ProcFileCache() : ProcFileCache(defaultCapacity()) {}
+
+ProcFileCache::ProcFileCache(const size_t capacity) : capacity(capacity) {}
+
+ProcFileCache::~ProcFileCache()
+{
+    for (auto& [pid, entry] : files)
+    {
+        closeFiles(entry);
+    }
+}
+
+size_t ProcFileCache::defaultCapacity()
+{
+    // Leave three quarters of ipmid's fd limit to everything else. The limit
+    // belongs to ipmid, so it is up to its service unit to raise it
+    // (LimitNOFILE) for more processes to fit.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0 ||
+        limit.rlim_cur == RLIM_INFINITY)
+    {
+        return maxCapacity;
+    }
+    return std::min<size_t>(limit.rlim_cur / 4 / leafCount, maxCapacity);
+}
+
+void ProcFileCache::closeFiles(Entry& entry)
+{
+    for (int& fd : entry.fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+std::string_view ProcFileCache::read(ProcFileReader& reader, const int pid,
+                                     const Leaf leaf)
+{
+    static constexpr std::array<std::string_view, leafCount> leafNames = {
+        "stat", "io", "cmdline"};
+    const std::string_view name = leafNames[leaf];
+
+    auto it = files.find(pid);
+    if (it == files.end())
+    {
+        if (files.size() >= capacity)
+        {
+            return reader.read(pid, name);
+        }
+        // Only processes with a file open take a slot.
+        int fd = openProcPidFile(pid, name);
+        if (fd < 0)
+        {
+            return reader.failed(errno);
+        }
+        it = files.emplace(pid, Entry{}).first;
+        it->second.fds[leaf] = fd;
+    }
+    Entry& entry = it->second;
+    entry.generation = generation;
+
+    int& fd = entry.fds[leaf];
+    if (fd == unopenable)
+    {
+        return reader.failed(EACCES);
+    }
+    if (fd < 0)
+    {
+        fd = openProcPidFile(pid, name);
+        if (fd < 0)
+        {
+            const int error = errno;
+            if (error == ENOENT || error == ESRCH)
+            {
+                closeFiles(entry);
+                files.erase(it);
+            }
+            else
+            {
+                // Such as io under a restrictive ptrace policy, which stays
+                // unreadable for the lifetime of the process.
+                fd = unopenable;
+            }
+            return reader.failed(error);
+        }
+    }
+    int error;
+    std::string_view content = reader.pread(fd, error);
+    if (error == ESRCH)
+    {
+        // The files belong to a process that exited, and the pid may already
+        // be someone else's; the next snapshot opens that one's files.
+        closeFiles(entry);
+        files.erase(it);
+        return reader.read(pid, name);
+    }
+    return content;
+}
+
+void ProcFileCache::endSnapshot()
+{
+    for (auto it = files.begin(); it != files.end();)
+    {
+        if (it->second.generation == generation)
+        {
+            ++it;
+            continue;
+        }
+        closeFiles(it->second);
+        it = files.erase(it);
+    }
+    ++generation;
+}
+
+namespace
+{
+
+/** What collectProcesses() needs for every process. */
+class Collector
+{
+  public:
+    Collector(ProcFileReader& reader, const long ticksPerSec,
+              const CollectOptions& options) :
+        reader(reader), files(options.files), taskstats(options.taskstats),
+        ticksPerSec(ticksPerSec),
+        invTicksPerSec(1.0f / static_cast<float>(ticksPerSec)),
+        pageKib(static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024)
+    {
+        if (taskstats != nullptr && !taskstats->available())
+        {
+            taskstats = nullptr;
+        }
+    }
+
+    std::string_view read(const int pid, const ProcFileCache::Leaf leaf)
+    {
+        if (files != nullptr)
+        {
+            return files->read(reader, pid, leaf);
+        }
+        switch (leaf)
+        {
+            case ProcFileCache::stat:
+                return reader.read(pid, "stat");
+            case ProcFileCache::io:
+                return reader.read(pid, "io");
+            default:
+                return reader.read(pid, "cmdline");
+        }
+    }
+
+    /**
+     * Reads the stat and I/O counters of info.pid, which change from one
+     * snapshot to the next, and its CPU times and delays from taskstats if
+     * enabled.
+     * @returns false if the process exited after it was listed.
+     */
+    bool readCounters(ProcPidStat& stat, ProcessInfo& info)
+    {
+        // An empty or unparsable stat means the process is gone.
+        if (!stat.parse(read(info.pid, ProcFileCache::stat),
+                        ProcPidStat::rss))
+        {
+            return false;
+        }
+        info.utimeTicks = stat.number(ProcPidStat::utime);
+        info.stimeTicks = stat.number(ProcPidStat::stime);
+        info.starttime = stat.number(ProcPidStat::starttime);
+        info.rssKib = stat.number(ProcPidStat::rss) * pageKib;
+        info.utime = static_cast<float>(info.utimeTicks) * invTicksPerSec;
+        info.stime = static_cast<float>(info.stimeTicks) * invTicksPerSec;
+        info.hasIo =
+            parseProcPidIo(read(info.pid, ProcFileCache::io), info.io);
+
+        // Taskstats only sums I/O bytes per thread, not per thread group, so
+        // those still come from the io file.
+        TaskStats ts;
+        if (taskstats != nullptr && taskstats->query(info.pid, ts))
+        {
+            info.utimeTicks = ts.utimeUs * ticksPerSec / 1000000;
+            info.stimeTicks = ts.stimeUs * ticksPerSec / 1000000;
+            info.taskstatsTicks = true;
+            info.utime = static_cast<float>(ts.utimeUs) / 1e6f;
+            info.stime = static_cast<float>(ts.stimeUs) / 1e6f;
+            info.hasDelays = true;
+            info.cpuDelay = static_cast<float>(ts.cpuDelayNs) / 1e9f;
+            info.blkioDelay = static_cast<float>(ts.blkioDelayNs) / 1e9f;
+            info.swapinDelay = static_cast<float>(ts.swapinDelayNs) / 1e9f;
+        }
+        return true;
+    }
+
+    ProcFileReader& reader;
+
+  private:
+    ProcFileCache* files;
+    TaskStatsClient* taskstats;
+    const long ticksPerSec;
+    const float invTicksPerSec;
+    const uint64_t pageKib;
+};
+
+} // namespace
+
+std::vector<ProcessInfo> collectProcesses(ProcFileReader& reader,
+                                          const long ticksPerSec,
+                                          const CollectOptions& options)
+{
+    constexpr std::string_view procPath = "/proc/";
+
+    std::vector<ProcessInfo> processes;
+    FdCounter fdCounter;
+    Collector collector(reader, ticksPerSec, options);
+    ProcessTable* table = options.table;
+
+    // A process without a readable fd directory still contributes to the
+    // procstat section.
+    auto add = [&](ProcessInfo&& info) {
+        if (options.countFds)
+        {
+            info.fdCount = fdCounter.count(info.pid);
+            if (info.fdCount < 0)
+            {
+                log<level::ERR>("Could not get file descriptor stats");
+            }
+        }
+        processes.push_back(std::move(info));
+    };
+
+    if (table != nullptr && table->update(reader))
+    {
+        // Entries of processes that are gone are removed after the walk, so
+        // that they do not cost a failed open in every snapshot and their pid
+        // is not mistaken for a thread that reuses it later.
+        std::vector<int> gone;
+        auto isGone = [&reader]() {
+            return reader.error() == ENOENT || reader.error() == ESRCH;
+        };
+        processes.reserve(table->entries().size());
+        for (const auto& [pid, entry] : table->entries())
+        {
+            ProcessInfo info;
+            info.pid = pid;
+            try
+            {
+                ProcPidStat stat;
+                if (!collector.readCounters(stat, info))
+                {
+                    if (isGone())
+                    {
+                        gone.push_back(pid);
+                    }
+                    continue;
+                }
+                // The pid was reused by a process whose events have not
+                // been received yet.
+                const ProcessTable::Entry* names = &entry;
+                if (entry.starttime != info.starttime)
+                {
+                    names = table->refresh(reader, pid);
+                    if (names == nullptr)
+                    {
+                        if (isGone())
+                        {
+                            gone.push_back(pid);
+                        }
+                        continue;
+                    }
+                }
+                info.cmdline = names->cmdline;
+                info.tcomm = names->tcomm;
+            }
+            catch (const std::exception& e)
+            {
+                log<level::ERR>("Could not obtain process stats");
+                continue;
+            }
+            add(std::move(info));
+        }
+        for (int pid : gone)
+        {
+            table->remove(pid);
+        }
+    }
+    else
+    {
+        std::error_code ec;
+        for (const auto& procEntry :
+             std::filesystem::directory_iterator(procPath, ec))
+        {
+            const std::string& path = procEntry.path();
+            int pid = -1;
+            if (!isNumericPath(path, pid))
+            {
+                continue;
+            }
+
+            ProcessInfo info;
+            info.pid = pid;
+            try
+            {
+                ProcPidStat stat;
+                if (!collector.readCounters(stat, info))
+                {
+                    continue;
+                }
+                info.tcomm = toTcomm(stat.field(ProcPidStat::comm));
+                info.cmdline =
+                    formatCmdLine(collector.read(pid, ProcFileCache::cmdline));
+            }
+            catch (const std::exception& e)
+            {
+                log<level::ERR>("Could not obtain process stats");
+                continue;
+            }
+            add(std::move(info));
+        }
+        if (ec)
+        {
+            log<level::ERR>("Could not list /proc");
+        }
+    }
+
+    if (options.files != nullptr)
+    {
+        options.files->endSnapshot();
+    }
+    return processes;
+}
+
+float ProcessRateTracker::update(
+    std::vector<ProcessInfo>& processes, const long ticksPerSec,
+    const std::chrono::steady_clock::time_point now)
+{
+    float interval = 0;
+    if (hasPrevious)
+    {
+        interval = std::chrono::duration<float>(now - previousTime).count();
+    }
+    const float ticksPerInterval = interval * static_cast<float>(ticksPerSec);
+
+    std::unordered_map<int, Sample> current;
+    current.reserve(processes.size());
+    for (ProcessInfo& proc : processes)
+    {
+        const uint64_t ticks = proc.utimeTicks + proc.stimeTicks;
+        current.emplace(proc.pid,
+                        Sample{proc.starttime, ticks, proc.taskstatsTicks,
+                               proc.hasIo, proc.io.writeBytes});
+
+        if (ticksPerInterval <= 0)
+        {
+            continue;
+        }
+        // A process that was not there last time, or whose pid was reused,
+        // started within the interval, so all of its ticks and writes count.
+        auto it = previous.find(proc.pid);
+        const Sample* last = nullptr;
+        if (it != previous.end() && it->second.starttime == proc.starttime)
+        {
+            last = &it->second;
+        }
+
+        // The two tick sources disagree, so a process that changed source
+        // restarts from the current sample instead of reporting a spike.
+        if (!last || last->taskstatsTicks == proc.taskstatsTicks)
+        {
+            uint64_t delta = ticks;
+            if (last && last->ticks <= ticks)
+            {
+                delta = ticks - last->ticks;
+            }
+            proc.cpuPercent =
+                100.0f * static_cast<float>(delta) / ticksPerInterval;
+        }
+
+        if (proc.hasIo)
+        {
+            uint64_t written = proc.io.writeBytes;
+            if (last && last->hasIo && last->writeBytes <= written)
+            {
+                written -= last->writeBytes;
+            }
+            proc.writeBytesPerSec = static_cast<float>(written) / interval;
+        }
+    }
+
+    // Exited processes are dropped by replacing the table wholesale.
+    previous.swap(current);
+    previousTime = now;
+    hasPrevious = true;
+    return interval;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,202 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "process_table.hpp"
+#include "taskstats.hpp"
+#include "util.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Everything the per-process metric sections need to know about one pid.
+ * A single walk of /proc fills one of these per live process.
+ */
+struct ProcessInfo
+{
+    int pid = 0;
+    std::string cmdline;
+    std::string tcomm;
+    float utime = 0;
+    float stime = 0;
+    uint64_t utimeTicks = 0;
+    uint64_t stimeTicks = 0;
+    // Whether the ticks come from taskstats, which are not scaled like those
+    // of /proc/<pid>/stat and so cannot be compared with them.
+    bool taskstatsTicks = false;
+    // Start time in clock ticks after boot, which tells pid reuse apart.
+    uint64_t starttime = 0;
+    // Resident set size in KiB.
+    uint64_t rssKib = 0;
+    // -1 if /proc/<pid>/fd could not be read.
+    int fdCount = -1;
+    // CPU usage since the previous snapshot, in percent of one CPU. Negative
+    // if there is no previous snapshot to compare with.
+    float cpuPercent = -1;
+    // Whether /proc/<pid>/io could be read, and its counters.
+    bool hasIo = false;
+    ProcPidIo io;
+    // Storage bytes written per second since the previous snapshot. Negative
+    // if there is no previous snapshot to compare with or no I/O counters.
+    float writeBytesPerSec = -1;
+    // Whether delay accounting was available, and the time in seconds the
+    // process waited for a CPU, for block I/O and for swap-in.
+    bool hasDelays = false;
+    float cpuDelay = 0;
+    float blkioDelay = 0;
+    float swapinDelay = 0;
+};
+
+/**
+ * Keeps the /proc/<pid> files read by every snapshot open from one snapshot
+ * to the next and re-reads them with pread(), which costs one syscall per
+ * file instead of an open, a read and a close.
+ *
+ * An open file stays bound to the process it was opened for: once that
+ * process exits, reads fail with ESRCH even if its pid was reused, which is
+ * when its files are closed. Files of processes a snapshot did not read are
+ * closed by endSnapshot(). A process only takes a slot once one of its
+ * files was opened, and a file that cannot be opened, such as io without
+ * ptrace access, is not tried again while the process is cached. At most
+ * capacity processes have files open; reads for any others open the file
+ * every time.
+ */
+class ProcFileCache
+{
+  public:
+    enum Leaf : size_t
+    {
+        stat,
+        io,
+        cmdline,
+        leafCount,
+    };
+
+    /**
+     * Uses a capacity whose files fit in a quarter of the soft fd limit of
+     * the process, and at most 1024 processes: 85 under the usual limit of
+     * 1024.
+     */
+    ProcFileCache();
+    explicit ProcFileCache(size_t capacity);
+    ~ProcFileCache();
+    ProcFileCache(const ProcFileCache&) = delete;
+    ProcFileCache& operator=(const ProcFileCache&) = delete;
+
+    /** Reads /proc/<pid>/<leaf> into reader's buffer, see ProcFileReader. */
+    std::string_view read(ProcFileReader& reader, int pid, Leaf leaf);
+
+    /** Closes the files of the processes not read since the last call. */
+    void endSnapshot();
+
+    /** Number of processes with files open. */
+    size_t size() const
+    {
+        return files.size();
+    }
+
+  private:
+    struct Entry
+    {
+        std::array<int, leafCount> fds = {-1, -1, -1};
+        uint32_t generation = 0;
+    };
+
+    static constexpr size_t maxCapacity = 1024;
+    // Marks a leaf of a cached process whose open failed, so that it is not
+    // tried again for that process.
+    static constexpr int unopenable = -2;
+    static size_t defaultCapacity();
+    static void closeFiles(Entry& entry);
+
+    const size_t capacity;
+    uint32_t generation = 0;
+    std::unordered_map<int, Entry> files;
+};
+
+/** How collectProcesses() gathers processes. */
+struct CollectOptions
+{
+    // Whether to count open fds, which is the most expensive part of the
+    // walk; fdCount is left at -1 otherwise.
+    bool countFds = true;
+    // If not null and process events are available, processes are listed
+    // from it instead of /proc and their names taken from it.
+    ProcessTable* table = nullptr;
+    // If not null and available, CPU times and delays come from taskstats,
+    // with microsecond rather than clock tick resolution.
+    TaskStatsClient* taskstats = nullptr;
+    // If not null, per-process files are kept open in it between snapshots.
+    ProcFileCache* files = nullptr;
+};
+
+/**
+ * Walks /proc once and gathers the stat, RSS, I/O counters, cmdline and fd
+ * count of every process. Processes that exit or cannot be read mid-walk are
+ * skipped.
+ * @param reader: reader whose buffer is reused for every file read
+ * @param ticksPerSec: clock ticks per second used to scale utime/stime
+ * @param options: what to gather and where from
+ * @returns One entry per process, in /proc directory or table order.
+ */
+std::vector<ProcessInfo> collectProcesses(ProcFileReader& reader,
+                                          long ticksPerSec,
+                                          const CollectOptions& options = {});
+
+/**
+ * Remembers the CPU ticks and bytes written of every process between
+ * snapshots, so that a snapshot can report what is using the CPU or wearing
+ * the flash now rather than over the whole lifetime of long running daemons.
+ */
+class ProcessRateTracker
+{
+  public:
+    /**
+     * Sets cpuPercent and writeBytesPerSec of every process from the ticks
+     * it used and the bytes it wrote since the previous call, and remembers
+     * the current counters for the next one. A process whose ticks switched
+     * between taskstats and /proc/<pid>/stat gets no CPU rate this time.
+     * @param processes: processes of the current snapshot
+     * @param ticksPerSec: clock ticks per second
+     * @param now: when the processes were collected
+     * @returns The interval in seconds the rates are computed over, or 0 on
+     *     the first call.
+     */
+    float update(std::vector<ProcessInfo>& processes, long ticksPerSec,
+                 std::chrono::steady_clock::time_point now);
+
+  private:
+    struct Sample
+    {
+        uint64_t starttime;
+        uint64_t ticks;
+        bool taskstatsTicks;
+        bool hasIo;
+        uint64_t writeBytes;
+    };
+    std::unordered_map<int, Sample> previous;
+    std::chrono::steady_clock::time_point previousTime;
+    bool hasPrevious = false;
+};
+
+} // namespace metric_blob
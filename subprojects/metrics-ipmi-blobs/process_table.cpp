@@ -0,0 +1,269 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "process_table.hpp"
+
+#include "util.hpp"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace metric_blob
+{
+
+using phosphor::logging::entry;
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+ProcessTable::ProcessTable()
+{
+    if (!subscribe())
+    {
+        log<level::WARNING>("Process events unavailable, walking /proc");
+    }
+}
+
+ProcessTable::~ProcessTable()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool ProcessTable::subscribe()
+{
+    fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                NETLINK_CONNECTOR);
+    if (fd < 0)
+    {
+        return false;
+    }
+    // Events queue up between snapshots; a larger buffer makes an overflow,
+    // and the rescan that follows, less likely when many processes start.
+    // Subscribing takes CAP_NET_ADMIN anyway, which also allows going past
+    // net.core.rmem_max, so SO_RCVBUF only caps the buffer without it.
+    int rcvbuf = 256 * 1024;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) <
+        0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    constexpr size_t payload = sizeof(cn_msg) + sizeof(proc_cn_mcast_op);
+    alignas(nlmsghdr) char buf[NLMSG_SPACE(payload)] = {};
+    auto* nlh = reinterpret_cast<nlmsghdr*>(buf);
+    nlh->nlmsg_len = NLMSG_LENGTH(payload);
+    nlh->nlmsg_type = NLMSG_DONE;
+    auto* msg = static_cast<cn_msg*>(NLMSG_DATA(nlh));
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(proc_cn_mcast_op);
+    const proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(msg->data, &op, sizeof(op));
+    if (send(fd, buf, nlh->nlmsg_len, 0) < 0)
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ProcessTable::receive()
+{
+    alignas(nlmsghdr) char buf[8192];
+    while (true)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // ENOBUFS means events were dropped.
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        auto* nlh = reinterpret_cast<nlmsghdr*>(buf);
+        for (size_t left = n; NLMSG_OK(nlh, left); nlh = NLMSG_NEXT(nlh, left))
+        {
+            if (nlh->nlmsg_type == NLMSG_ERROR ||
+                nlh->nlmsg_type == NLMSG_OVERRUN)
+            {
+                return false;
+            }
+            const auto* msg = static_cast<const cn_msg*>(NLMSG_DATA(nlh));
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC ||
+                msg->len < sizeof(proc_event))
+            {
+                continue;
+            }
+            proc_event event;
+            std::memcpy(&event, msg->data, sizeof(event));
+            switch (event.what)
+            {
+                case proc_event::PROC_EVENT_FORK:
+                    // New threads share their process's entry.
+                    if (event.event_data.fork.child_pid ==
+                        event.event_data.fork.child_tgid)
+                    {
+                        changed.push_back(event.event_data.fork.child_tgid);
+                    }
+                    break;
+                case proc_event::PROC_EVENT_EXEC:
+                    changed.push_back(event.event_data.exec.process_tgid);
+                    break;
+                case proc_event::PROC_EVENT_COMM:
+                    changed.push_back(event.event_data.comm.process_tgid);
+                    break;
+                case proc_event::PROC_EVENT_EXIT:
+                    // The leader may exit before the other threads, which
+                    // keep the process running; whether it did is checked
+                    // once the events are applied.
+                    if (event.event_data.exit.process_pid ==
+                            event.event_data.exit.process_tgid ||
+                        zombieLeaders.contains(
+                            event.event_data.exit.process_tgid))
+                    {
+                        exited.push_back(event.event_data.exit.process_tgid);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void ProcessTable::rescan()
+{
+    table.clear();
+    changed.clear();
+    zombieLeaders.clear();
+    std::error_code ec;
+    for (const auto& procEntry :
+         std::filesystem::directory_iterator("/proc/", ec))
+    {
+        int pid = -1;
+        if (isNumericPath(procEntry.path().native(), pid))
+        {
+            changed.push_back(pid);
+        }
+    }
+    if (ec)
+    {
+        log<level::ERR>("Could not list /proc");
+    }
+}
+
+bool ProcessTable::update(ProcFileReader& reader)
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+    // Events received before the walk may be applied again after it, which
+    // is harmless; events sent during it are not lost.
+    if (!receive() || !synced)
+    {
+        if (synced)
+        {
+            ++overflows;
+            log<level::WARNING>("Process events lost, walking /proc",
+                                entry("OVERFLOWS=%u", overflows));
+        }
+        rescan();
+        synced = true;
+    }
+    for (int pid : changed)
+    {
+        if (!refresh(reader, pid))
+        {
+            table.erase(pid);
+        }
+    }
+    changed.clear();
+    // After the refreshes, which would otherwise add back exited processes
+    // whose fork or exec came in the same update.
+    for (int tgid : exited)
+    {
+        checkExited(reader, tgid);
+    }
+    exited.clear();
+    return true;
+}
+
+void ProcessTable::checkExited(ProcFileReader& reader, const int tgid)
+{
+    ProcPidStat stat;
+    if (!stat.parse(reader.read(tgid, "stat"), ProcPidStat::numThreads))
+    {
+        remove(tgid);
+        return;
+    }
+    if (stat.field(ProcPidStat::state) != "Z")
+    {
+        // The pid was reused by a new process.
+        zombieLeaders.erase(tgid);
+        return;
+    }
+    // A zombie leader still counts itself until it is reaped.
+    if (stat.number(ProcPidStat::numThreads) > 1)
+    {
+        zombieLeaders.insert(tgid);
+        return;
+    }
+    remove(tgid);
+}
+
+const ProcessTable::Entry* ProcessTable::refresh(ProcFileReader& reader,
+                                                 const int pid)
+{
+    ProcPidStat stat;
+    if (!stat.parse(reader.read(pid, "stat"), ProcPidStat::starttime))
+    {
+        return nullptr;
+    }
+    Entry& entry = table[pid];
+    entry.tcomm = toTcomm(stat.field(ProcPidStat::comm));
+    entry.starttime = stat.number(ProcPidStat::starttime);
+    entry.cmdline = getCmdLine(reader, pid);
+    return &entry;
+}
+
+} // namespace metric_blob
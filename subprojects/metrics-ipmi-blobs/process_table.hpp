@@ -0,0 +1,113 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "util.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Names of every live process, kept up to date from the kernel's process
+ * events connector (cn_proc) rather than rediscovered by each snapshot.
+ * Forks, execs, comm changes and exits arrive on a netlink socket; only the
+ * processes they name are read again, so on a BMC of long-running daemons a
+ * snapshot neither walks /proc nor reads a single cmdline.
+ *
+ * Subscribing takes CAP_NET_ADMIN. If it fails, or events were lost because
+ * the socket buffer overflowed, update() reports the table as unusable or
+ * rebuilds it from a walk of /proc.
+ */
+class ProcessTable
+{
+  public:
+    struct Entry
+    {
+        std::string cmdline;
+        // comm in parentheses, as reported after the cmdline.
+        std::string tcomm;
+        // Start time in clock ticks after boot, which tells pid reuse apart.
+        uint64_t starttime = 0;
+    };
+
+    ProcessTable();
+    ~ProcessTable();
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    /**
+     * Applies the process events received since the previous call.
+     * @param reader: reader used for the processes that changed
+     * @returns false if process events are not available, in which case the
+     *     table is empty.
+     */
+    bool update(ProcFileReader& reader);
+
+    /** Processes by pid. */
+    const std::unordered_map<int, Entry>& entries() const
+    {
+        return table;
+    }
+
+    /**
+     * Reads the names of pid again, for a process found to have a different
+     * start time than its entry.
+     * @returns The new entry, or nullptr if the process is gone.
+     */
+    const Entry* refresh(ProcFileReader& reader, int pid);
+
+    /**
+     * Drops the entry of a process found to be gone, whose exit event came
+     * before it was reaped or was lost.
+     */
+    void remove(int pid)
+    {
+        table.erase(pid);
+        zombieLeaders.erase(pid);
+    }
+
+  private:
+    bool subscribe();
+    /** Reads pending events; returns false if some were lost. */
+    bool receive();
+    void rescan();
+    /**
+     * Drops the entry of a process whose leader thread exited, unless other
+     * threads of the process are still running.
+     */
+    void checkExited(ProcFileReader& reader, int tgid);
+
+    int fd = -1;
+    bool synced = false;
+    // Times events were lost since the table subscribed.
+    uint32_t overflows = 0;
+    std::unordered_map<int, Entry> table;
+    // Pids forked, exec'd or renamed since the last update().
+    std::vector<int> changed;
+    // Processes whose leader or, for those in zombieLeaders, any thread
+    // exited since the last update().
+    std::vector<int> exited;
+    // Processes whose leader exited while other threads kept running.
+    std::unordered_set<int> zombieLeaders;
+};
+
+} // namespace metric_blob
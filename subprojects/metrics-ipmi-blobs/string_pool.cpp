@@ -0,0 +1,97 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "string_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+void StringPool::beginSnapshot()
+{
+    // Strings of exited processes pile up in the arena. Once they outnumber
+    // the ones the last snapshot used, copy the live ones to a fresh arena.
+    constexpr size_t minCompactSize = 64;
+    if (index.size() >= minCompactSize && index.size() > 2 * table.size())
+    {
+        compact();
+    }
+    table.clear();
+    ++generation;
+}
+
+int StringPool::getStringID(std::string_view s)
+{
+    auto it = index.find(s);
+    if (it == index.end())
+    {
+        it = index.emplace(store(s), Entry{generation - 1, 0}).first;
+    }
+    Entry& entry = it->second;
+    if (entry.generation != generation)
+    {
+        entry.generation = generation;
+        entry.id = static_cast<int>(table.size());
+        table.push_back(it->first);
+    }
+    return entry.id;
+}
+
+std::string_view StringPool::store(std::string_view s)
+{
+    if (s.size() > left)
+    {
+        // A string that does not fit in a chunk gets a chunk of its own.
+        // Whatever is left of the current chunk is given up, which wastes
+        // little since cmdlines are short compared to a chunk.
+        size_t size = std::max(s.size(), chunkSize);
+        chunks.push_back(std::make_unique<char[]>(size));
+        next = chunks.back().get();
+        left = size;
+    }
+    if (!s.empty())
+    {
+        std::memcpy(next, s.data(), s.size());
+    }
+    std::string_view ret(next, s.size());
+    next += s.size();
+    left -= s.size();
+    return ret;
+}
+
+void StringPool::compact()
+{
+    // Only the strings of the last string table survive, with their entries
+    // unchanged so that they are not handed out as new.
+    std::unordered_map<std::string_view, Entry> oldIndex;
+    oldIndex.swap(index);
+    std::vector<std::unique_ptr<char[]>> oldChunks;
+    oldChunks.swap(chunks);
+    next = nullptr;
+    left = 0;
+
+    index.reserve(table.size());
+    for (std::string_view& s : table)
+    {
+        s = index.emplace(store(s), oldIndex.at(s)).first->first;
+    }
+}
+
+} // namespace metric_blob
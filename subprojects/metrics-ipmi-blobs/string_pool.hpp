@@ -0,0 +1,94 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Interns the strings referenced by snapshots (cmdlines, mostly) and hands
+ * out the string table indices for them.
+ *
+ * The characters live in an arena that is kept from one snapshot to the next,
+ * so a daemon that shows up in every snapshot costs one hash lookup per
+ * snapshot and no allocation. Indices are per snapshot: they are assigned in
+ * order of first use since beginSnapshot(), so the string table is simply
+ * strings() walked in order.
+ */
+class StringPool
+{
+  public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * Starts a new string table. Indices handed out before are forgotten,
+     * and strings no snapshot used recently may be dropped from the arena.
+     */
+    void beginSnapshot();
+
+    /**
+     * Returns the index of the provided string in the current string table,
+     * adding it if this is its first use since beginSnapshot().
+     */
+    int getStringID(std::string_view s);
+
+    /**
+     * Strings of the current string table, in index order. The views stay
+     * valid until the next beginSnapshot().
+     */
+    const std::vector<std::string_view>& strings() const
+    {
+        return table;
+    }
+
+    /** Number of strings interned in the arena, used or not. */
+    size_t size() const
+    {
+        return index.size();
+    }
+
+  private:
+    struct Entry
+    {
+        // Snapshot the string was last used in, and its index there.
+        uint32_t generation;
+        int id;
+    };
+
+    std::string_view store(std::string_view s);
+    void compact();
+
+    static constexpr size_t chunkSize = 4096;
+
+    // Keys point into the arena chunks, which never move.
+    std::unordered_map<std::string_view, Entry> index;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* next = nullptr;
+    size_t left = 0;
+    std::vector<std::string_view> table;
+    uint32_t generation = 0;
+};
+
+} // namespace metric_blob
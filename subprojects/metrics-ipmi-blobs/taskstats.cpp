@@ -0,0 +1,219 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "taskstats.hpp"
+
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace metric_blob
+{
+
+using phosphor::logging::log;
+using level = phosphor::logging::level;
+
+namespace
+{
+
+// Generic netlink payload of a received message.
+const char* payload(const nlmsghdr* nlh)
+{
+    return static_cast<const char*>(NLMSG_DATA(nlh)) + GENL_HDRLEN;
+}
+
+/**
+ * Calls f(type, data, size) for every attribute in [data, data + size).
+ */
+template <typename F>
+void forEachAttribute(const char* data, size_t size, F f)
+{
+    while (size >= NLA_HDRLEN)
+    {
+        nlattr attr;
+        std::memcpy(&attr, data, sizeof(attr));
+        if (attr.nla_len < NLA_HDRLEN || attr.nla_len > size)
+        {
+            return;
+        }
+        f(attr.nla_type & NLA_TYPE_MASK, data + NLA_HDRLEN,
+          static_cast<size_t>(attr.nla_len - NLA_HDRLEN));
+        size_t step = std::min<size_t>(NLA_ALIGN(attr.nla_len), size);
+        data += step;
+        size -= step;
+    }
+}
+
+} // namespace
+
+TaskStatsClient::TaskStatsClient()
+{
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (fd < 0 || !resolveFamily())
+    {
+        log<level::WARNING>("Taskstats unavailable");
+    }
+}
+
+TaskStatsClient::~TaskStatsClient()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool TaskStatsClient::request(uint16_t family, uint8_t command,
+                              uint16_t attribute, const void* value,
+                              uint16_t size)
+{
+    buffer.fill(0);
+    auto* nlh = reinterpret_cast<nlmsghdr*>(buffer.data());
+    nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_HDRLEN + NLA_ALIGN(size));
+    nlh->nlmsg_type = family;
+    nlh->nlmsg_flags = NLM_F_REQUEST;
+    nlh->nlmsg_seq = ++seq;
+    auto* genl = static_cast<genlmsghdr*>(NLMSG_DATA(nlh));
+    genl->cmd = command;
+    genl->version = 1;
+    auto* attr = reinterpret_cast<nlattr*>(reinterpret_cast<char*>(genl) +
+                                           GENL_HDRLEN);
+    attr->nla_type = attribute;
+    attr->nla_len = NLA_HDRLEN + size;
+    std::memcpy(reinterpret_cast<char*>(attr) + NLA_HDRLEN, value, size);
+
+    sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+    return sendto(fd, nlh, nlh->nlmsg_len, 0,
+                  reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) ==
+           static_cast<ssize_t>(nlh->nlmsg_len);
+}
+
+int TaskStatsClient::receive()
+{
+    // The kernel replies from within sendto(), so the reply is already
+    // queued, unless it was for an earlier request that failed midway.
+    while (true)
+    {
+        ssize_t n = recv(fd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+        if (n < static_cast<ssize_t>(NLMSG_HDRLEN))
+        {
+            return -1;
+        }
+        const auto* nlh = reinterpret_cast<const nlmsghdr*>(buffer.data());
+        if (!NLMSG_OK(nlh, static_cast<size_t>(n)))
+        {
+            return -1;
+        }
+        if (nlh->nlmsg_seq != seq)
+        {
+            continue;
+        }
+        if (nlh->nlmsg_type == NLMSG_ERROR ||
+            nlh->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+        {
+            return -1;
+        }
+        return static_cast<int>(nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+    }
+}
+
+bool TaskStatsClient::resolveFamily()
+{
+    constexpr std::string_view name = TASKSTATS_GENL_NAME;
+    char value[name.size() + 1] = {};
+    name.copy(value, name.size());
+    if (!request(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME,
+                 value, sizeof(value)))
+    {
+        return false;
+    }
+    int size = receive();
+    if (size < 0)
+    {
+        return false;
+    }
+    const auto* nlh = reinterpret_cast<const nlmsghdr*>(buffer.data());
+    forEachAttribute(payload(nlh), size,
+                     [this](int type, const char* data, size_t len) {
+                         if (type == CTRL_ATTR_FAMILY_ID &&
+                             len >= sizeof(familyId))
+                         {
+                             std::memcpy(&familyId, data, sizeof(familyId));
+                         }
+                     });
+    return familyId != 0;
+}
+
+bool TaskStatsClient::query(int tgid, TaskStats& stats)
+{
+    if (familyId == 0)
+    {
+        return false;
+    }
+    const uint32_t id = static_cast<uint32_t>(tgid);
+    if (!request(familyId, TASKSTATS_CMD_GET, TASKSTATS_CMD_ATTR_TGID, &id,
+                 sizeof(id)))
+    {
+        return false;
+    }
+    int size = receive();
+    if (size < 0)
+    {
+        return false;
+    }
+
+    // The reply nests the statistics in an AGGR_TGID attribute. Older
+    // kernels send a shorter struct, whose missing fields stay zero.
+    taskstats ts = {};
+    bool found = false;
+    const auto* nlh = reinterpret_cast<const nlmsghdr*>(buffer.data());
+    forEachAttribute(
+        payload(nlh), size, [&](int type, const char* data, size_t len) {
+            if (type != TASKSTATS_TYPE_AGGR_TGID)
+            {
+                return;
+            }
+            forEachAttribute(data, len, [&](int inner, const char* stat,
+                                            size_t statLen) {
+                if (inner == TASKSTATS_TYPE_STATS)
+                {
+                    std::memcpy(&ts, stat, std::min(statLen, sizeof(ts)));
+                    found = true;
+                }
+            });
+        });
+    if (!found)
+    {
+        return false;
+    }
+    stats.utimeUs = ts.ac_utime;
+    stats.stimeUs = ts.ac_stime;
+    stats.cpuDelayNs = ts.cpu_delay_total;
+    stats.blkioDelayNs = ts.blkio_delay_total;
+    stats.swapinDelayNs = ts.swapin_delay_total;
+    return true;
+}
+
+} // namespace metric_blob
@@ -0,0 +1,78 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace metric_blob
+{
+
+/** Per-process statistics of the taskstats interface, summed over threads. */
+struct TaskStats
+{
+    // CPU time in microseconds.
+    uint64_t utimeUs = 0;
+    uint64_t stimeUs = 0;
+    // Time spent waiting for a CPU, for block I/O and for swap-in, in
+    // nanoseconds. Zero unless delay accounting is enabled
+    // (kernel.task_delayacct).
+    uint64_t cpuDelayNs = 0;
+    uint64_t blkioDelayNs = 0;
+    uint64_t swapinDelayNs = 0;
+};
+
+/**
+ * Queries the kernel's TASKSTATS generic netlink family, which returns
+ * binary per-process statistics including delay accounting, which /proc/<pid>
+ * text files do not have. One query is a single request and reply on a
+ * socket kept open across snapshots.
+ */
+class TaskStatsClient
+{
+  public:
+    TaskStatsClient();
+    ~TaskStatsClient();
+    TaskStatsClient(const TaskStatsClient&) = delete;
+    TaskStatsClient& operator=(const TaskStatsClient&) = delete;
+
+    /** Whether the kernel has taskstats (CONFIG_TASKSTATS). */
+    bool available() const
+    {
+        return familyId != 0;
+    }
+
+    /**
+     * Gets the statistics of a thread group, live threads and exited ones.
+     * @returns false if the process is gone or the query failed.
+     */
+    bool query(int tgid, TaskStats& stats);
+
+  private:
+    /** Sends a generic netlink request with one u32 attribute. */
+    bool request(uint16_t family, uint8_t command, uint16_t attribute,
+                 const void* value, uint16_t size);
+    /** Receives the reply to the last request; returns its payload size. */
+    int receive();
+    bool resolveFamily();
+
+    int fd = -1;
+    uint16_t familyId = 0;
+    uint32_t seq = 0;
+    alignas(8) std::array<char, 4096> buffer;
+};
+
+} // namespace metric_blob
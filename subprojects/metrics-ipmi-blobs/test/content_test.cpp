@@ -0,0 +1,98 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "content.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// Content that is only readable once marked done, like a snapshot being
+// collected.
+class PendingContent : public metric_blob::BlobContent
+{
+  public:
+    explicit PendingContent(std::string data) : data(data.begin(), data.end())
+    {}
+
+    std::string_view read(uint32_t offset,
+                          uint32_t requestedSize) const override
+    {
+        return done ? metric_blob::readAt(data, offset, requestedSize)
+                    : std::string_view();
+    }
+
+    bool stat(blobs::BlobMeta& meta) const override
+    {
+        if (!done)
+        {
+            meta.blobState |= 1 << 8;
+            return true;
+        }
+        meta.blobState = blobs::StateFlags::open_read;
+        meta.size = data.size();
+        return true;
+    }
+
+    bool done = false;
+
+  private:
+    std::vector<char> data;
+};
+
+} // namespace
+
+TEST(EncodedContent, readsAndStats)
+{
+    metric_blob::EncodedContent content(std::vector<char>{'a', 'b', 'c'});
+    blobs::BlobMeta meta{};
+    ASSERT_TRUE(content.stat(meta));
+    EXPECT_EQ(meta.blobState, blobs::StateFlags::open_read);
+    EXPECT_EQ(meta.size, 3);
+    EXPECT_EQ(content.read(1, 10), "bc");
+    EXPECT_EQ(content.read(3, 10), "");
+}
+
+TEST(CompressedContent, waitsForContent)
+{
+    auto raw = std::make_shared<PendingContent>(std::string(1000, 'x'));
+    metric_blob::CompressedContent content(raw);
+
+    blobs::BlobMeta meta{};
+    ASSERT_TRUE(content.stat(meta));
+    EXPECT_EQ(meta.blobState, 1 << 8);
+    EXPECT_TRUE(meta.metadata.empty());
+    EXPECT_EQ(content.read(0, 100), "");
+
+    raw->done = true;
+    meta = {};
+    ASSERT_TRUE(content.stat(meta));
+    EXPECT_EQ(meta.blobState, blobs::StateFlags::open_read);
+    EXPECT_LT(meta.size, 100);
+    EXPECT_EQ(content.read(0, std::numeric_limits<uint32_t>::max()).size(),
+              meta.size);
+    // Compression type, then 1000 as a little-endian 32-bit integer.
+    EXPECT_EQ(meta.metadata,
+              (std::vector<uint8_t>{metric_blob::compressionLz4Block, 0xe8,
+                                    0x03, 0x00, 0x00}));
+}
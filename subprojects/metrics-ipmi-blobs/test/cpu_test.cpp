@@ -0,0 +1,62 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(CollectCpuStats, aggregateFirst)
+{
+    metric_blob::ProcFileReader reader;
+    auto cpus = metric_blob::collectCpuStats(reader);
+    ASSERT_GE(cpus.size(), 2u);
+    EXPECT_EQ(cpus[0].cpu, -1);
+    EXPECT_EQ(cpus[1].cpu, 0);
+    EXPECT_GT(cpus[0].times.idle, 0);
+}
+
+TEST(CpuStatTracker, utilizationSincePreviousUpdate)
+{
+    using namespace std::chrono_literals;
+    metric_blob::CpuStatTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<metric_blob::CpuStat> cpus = {
+        {.cpu = -1, .times = {.user = 100, .idle = 1000}},
+        {.cpu = 0, .times = {.user = 90, .idle = 400}},
+        {.cpu = 1, .times = {.user = 10, .idle = 600}},
+    };
+    EXPECT_EQ(tracker.update(cpus, t0), 0);
+    EXPECT_LT(cpus[0].userPercent, 0);
+
+    // CPU 0 was pegged by user space for the 2 s interval while CPU 1 was
+    // idle but for some iowait, and CPU 2 came online.
+    cpus = {
+        {.cpu = -1, .times = {.user = 300, .idle = 1190, .iowait = 10}},
+        {.cpu = 0, .times = {.user = 290, .idle = 400}},
+        {.cpu = 1, .times = {.user = 10, .idle = 790, .iowait = 10}},
+        {.cpu = 2, .times = {.idle = 5}},
+    };
+    EXPECT_FLOAT_EQ(tracker.update(cpus, t0 + 2s), 2);
+    EXPECT_FLOAT_EQ(cpus[0].userPercent, 50);
+    EXPECT_FLOAT_EQ(cpus[0].iowaitPercent, 2.5);
+    EXPECT_FLOAT_EQ(cpus[1].userPercent, 100);
+    EXPECT_FLOAT_EQ(cpus[1].systemPercent, 0);
+    EXPECT_FLOAT_EQ(cpus[2].userPercent, 0);
+    EXPECT_FLOAT_EQ(cpus[2].iowaitPercent, 5);
+    EXPECT_LT(cpus[3].userPercent, 0);
+}
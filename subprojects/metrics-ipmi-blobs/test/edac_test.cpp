@@ -0,0 +1,80 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "edac.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+class EdacCountersTest : public ::testing::Test
+{
+  protected:
+    EdacCountersTest() :
+        root(std::filesystem::temp_directory_path() /
+             ("edac_test_" + std::to_string(getpid())))
+    {
+        std::filesystem::create_directories(root);
+    }
+
+    ~EdacCountersTest() override
+    {
+        std::filesystem::remove_all(root);
+    }
+
+    void setCounts(const std::string& mc, int ce, int ue)
+    {
+        std::filesystem::create_directories(root / mc);
+        std::ofstream(root / mc / "ce_count") << ce << "\n";
+        std::ofstream(root / mc / "ue_count") << ue << "\n";
+    }
+
+    std::filesystem::path root;
+};
+
+} // namespace
+
+TEST_F(EdacCountersTest, noControllers)
+{
+    std::filesystem::create_directories(root / "power");
+    metric_blob::EdacCounters edac(root);
+    metric_blob::EccCounts counts;
+    EXPECT_FALSE(edac.read(counts));
+}
+
+TEST_F(EdacCountersTest, sumsControllers)
+{
+    setCounts("mc0", 3, 0);
+    setCounts("mc1", 4, 1);
+    setCounts("mcx", 100, 100);
+    metric_blob::EdacCounters edac(root);
+    metric_blob::EccCounts counts;
+    ASSERT_TRUE(edac.read(counts));
+    EXPECT_EQ(counts.correctableErrCount, 7);
+    EXPECT_EQ(counts.uncorrectableErrCount, 1);
+
+    // The files stay open and are read again.
+    setCounts("mc0", 5, 2);
+    ASSERT_TRUE(edac.read(counts));
+    EXPECT_EQ(counts.correctableErrCount, 9);
+    EXPECT_EQ(counts.uncorrectableErrCount, 3);
+}
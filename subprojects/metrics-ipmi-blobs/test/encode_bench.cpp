@@ -0,0 +1,149 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "encode.hpp"
+
+#include <pb_encode.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace
+{
+
+constexpr size_t numProcesses = 500;
+
+// A snapshot with every process reported, as if topN were 500.
+class BigSnapshot
+{
+  public:
+    BigSnapshot()
+    {
+        for (size_t i = 0; i < numProcesses; ++i)
+        {
+            cmdlines.push_back("/usr/bin/some-daemon --instance=" +
+                               std::to_string(i) + " (some-daemon)");
+            auto& proc = procs.emplace_back();
+            proc.sidx_cmdline = static_cast<int32_t>(i);
+            proc.utime = static_cast<float>(i) * 1.5f;
+            proc.stime = static_cast<float>(i) * 0.5f;
+            proc.has_cpu_percent = true;
+            proc.cpu_percent = 0.25f;
+            fds.push_back({
+                .sidx_cmdline = static_cast<int32_t>(i),
+                .fd_count = static_cast<int32_t>(i % 64),
+            });
+            // The columns of the same processes, as section::columnar
+            // requests them.
+            sidxDeltas.push_back(i == 0 ? 0 : 1);
+            utimeTicks.push_back(i * 150);
+            stimeTicks.push_back(i * 50);
+            cpuPercent.push_back(0.25f);
+            fdCounts.push_back(i % 64);
+        }
+
+        // Like the real string table callback, rebuild the views every time
+        // it runs.
+        static constexpr auto stcb = [](pb_ostream_t* stream,
+                                        const pb_field_t* field,
+                                        void* const* arg) noexcept {
+            const auto& self = *reinterpret_cast<const BigSnapshot*>(*arg);
+            std::vector<std::string_view> strs(self.cmdlines.begin(),
+                                               self.cmdlines.end());
+            return metric_blob::pbEncodeStringEntries(stream, field, strs);
+        };
+
+        snapshot = {};
+        snapshot.has_string_table = true;
+        snapshot.string_table = {.entries = {{.encode = stcb}, this}};
+        snapshot.has_memory_metric = true;
+        snapshot.memory_metric = {
+            .mem_available = 500000, .slab = 20000, .kernel_stack = 2000};
+        snapshot.has_procstat_metric = true;
+        auto& procstat = snapshot.procstat_metric;
+        procstat.stats = metric_blob::pbSubsEncoder<
+            bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat_fields>(procs);
+        procstat.has_cpu_interval_sec = true;
+        procstat.cpu_interval_sec = 10;
+        procstat.sidx_cmdline_delta = metric_blob::pbPackedEncoder(sidxDeltas);
+        procstat.utime_ticks = metric_blob::pbPackedEncoder(utimeTicks);
+        procstat.stime_ticks = metric_blob::pbPackedEncoder(stimeTicks);
+        procstat.has_ticks_per_sec = true;
+        procstat.ticks_per_sec = 100;
+        procstat.cpu_percent = metric_blob::pbPackedEncoder(cpuPercent);
+        snapshot.has_fdstat_metric = true;
+        snapshot.fdstat_metric.stats = metric_blob::pbSubsEncoder<
+            bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat_fields>(fds);
+        snapshot.fdstat_metric.sidx_cmdline_delta =
+            metric_blob::pbPackedEncoder(sidxDeltas);
+        snapshot.fdstat_metric.fd_count =
+            metric_blob::pbPackedEncoder(fdCounts);
+    }
+    BigSnapshot(const BigSnapshot&) = delete;
+    BigSnapshot& operator=(const BigSnapshot&) = delete;
+
+    std::vector<std::string> cmdlines;
+    std::vector<bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat> procs;
+    std::vector<bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat> fds;
+    std::vector<int32_t> sidxDeltas;
+    std::vector<uint64_t> utimeTicks;
+    std::vector<uint64_t> stimeTicks;
+    std::vector<float> cpuPercent;
+    std::vector<uint32_t> fdCounts;
+    bmcmetrics_metricproto_BmcMetricSnapshot snapshot;
+};
+
+// What BmcHealthSnapshot::doWork did before encodeSnapshot(): a sizing pass
+// followed by a writing pass.
+void BM_EncodeTwoPass(benchmark::State& state)
+{
+    BigSnapshot big;
+    std::vector<char> out;
+    for (auto _ : state)
+    {
+        pb_ostream_t nost = {};
+        pb_encode(&nost, bmcmetrics_metricproto_BmcMetricSnapshot_fields,
+                  &big.snapshot);
+        out.resize(nost.bytes_written);
+        auto ost = pb_ostream_from_buffer(
+            reinterpret_cast<pb_byte_t*>(out.data()), out.size());
+        benchmark::DoNotOptimize(
+            pb_encode(&ost, bmcmetrics_metricproto_BmcMetricSnapshot_fields,
+                      &big.snapshot));
+    }
+    state.counters["bytes"] = out.size();
+}
+BENCHMARK(BM_EncodeTwoPass);
+
+void BM_EncodeSinglePass(benchmark::State& state)
+{
+    BigSnapshot big;
+    std::vector<char> out;
+    const char* error = nullptr;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            metric_blob::encodeSnapshot(big.snapshot, out, error));
+    }
+    state.counters["bytes"] = out.size();
+}
+BENCHMARK(BM_EncodeSinglePass);
+
+} // namespace
+
+BENCHMARK_MAIN();
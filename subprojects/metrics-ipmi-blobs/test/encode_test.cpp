@@ -0,0 +1,386 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "encode.hpp"
+
+#include "metricblob.pb.n.h"
+
+#include <pb_decode.h>
+#include <pb_encode.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+constexpr auto encodeStrings = [](pb_ostream_t* stream,
+                                  const pb_field_t* field,
+                                  void* const* arg) noexcept {
+    const auto& strs =
+        *reinterpret_cast<const std::vector<std::string_view>*>(*arg);
+    return metric_blob::pbEncodeStringEntries(stream, field, strs);
+};
+
+bmcmetrics_metricproto_BmcStringTable
+    stringTable(const std::vector<std::string_view>& strs)
+{
+    return {.entries = {{.encode = encodeStrings},
+                        const_cast<std::vector<std::string_view>*>(&strs)}};
+}
+
+// What BmcHealthSnapshot::doWork did before encodeSnapshot(): a sizing pass
+// followed by a writing pass.
+std::vector<char> encodeTwoPass(const pb_msgdesc_t* fields, const void* msg)
+{
+    pb_ostream_t sizing = PB_OSTREAM_SIZING;
+    EXPECT_TRUE(pb_encode(&sizing, fields, msg));
+    std::vector<char> out(sizing.bytes_written);
+    pb_ostream_t stream = pb_ostream_from_buffer(
+        reinterpret_cast<pb_byte_t*>(out.data()), out.size());
+    EXPECT_TRUE(pb_encode(&stream, fields, msg));
+    EXPECT_EQ(stream.bytes_written, out.size());
+    return out;
+}
+
+pb_istream_t istream(const std::vector<char>& data)
+{
+    return pb_istream_from_buffer(
+        reinterpret_cast<const pb_byte_t*>(data.data()), data.size());
+}
+
+bool decodeString(pb_istream_t* stream, const pb_field_t*, void** arg)
+{
+    auto& str = *reinterpret_cast<std::string*>(*arg);
+    str.resize(stream->bytes_left);
+    return pb_read(stream, reinterpret_cast<pb_byte_t*>(str.data()),
+                   str.size());
+}
+
+bool decodeStringEntry(pb_istream_t* stream, const pb_field_t*, void** arg)
+{
+    auto& strs = *reinterpret_cast<std::vector<std::string>*>(*arg);
+    std::string& str = strs.emplace_back();
+    bmcmetrics_metricproto_BmcStringTable_StringEntry entry = {
+        .value = {{.decode = decodeString}, &str}};
+    return pb_decode(stream,
+                     bmcmetrics_metricproto_BmcStringTable_StringEntry_fields,
+                     &entry);
+}
+
+pb_callback_t stringEntriesDecoder(std::vector<std::string>& strs)
+{
+    return {{.decode = decodeStringEntry}, &strs};
+}
+
+// Called once per element, whether the field is packed or not.
+template <typename T>
+bool decodeScalar(pb_istream_t* stream, const pb_field_t*, void** arg)
+{
+    T value;
+    bool ok;
+    if constexpr (std::is_same_v<T, float>)
+    {
+        ok = pb_decode_fixed32(stream, &value);
+    }
+    else if constexpr (std::is_signed_v<T>)
+    {
+        int64_t v;
+        ok = pb_decode_svarint(stream, &v);
+        value = static_cast<T>(v);
+    }
+    else
+    {
+        uint64_t v;
+        ok = pb_decode_varint(stream, &v);
+        value = static_cast<T>(v);
+    }
+    reinterpret_cast<std::vector<T>*>(*arg)->push_back(value);
+    return ok;
+}
+
+template <typename T>
+pb_callback_t scalarsDecoder(std::vector<T>& values)
+{
+    return {{.decode = decodeScalar<T>}, &values};
+}
+
+template <auto fields, typename T>
+bool decodeSub(pb_istream_t* stream, const pb_field_t*, void** arg)
+{
+    T& sub = reinterpret_cast<std::vector<T>*>(*arg)->emplace_back();
+    return pb_decode(stream, fields, &sub);
+}
+
+template <auto fields, typename T>
+pb_callback_t subsDecoder(std::vector<T>& subs)
+{
+    return {{.decode = decodeSub<fields, T>}, &subs};
+}
+
+using ProcStat = bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat;
+using FdStat = bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat;
+using Sample = bmcmetrics_metricproto_BmcMetricHistory_Sample;
+using TopProcess = bmcmetrics_metricproto_BmcMetricHistory_TopProcess;
+
+// A negative cpuPercent leaves it unset.
+ProcStat procStat(int32_t sidx, float utime, float stime, float cpuPercent)
+{
+    ProcStat stat = {};
+    stat.sidx_cmdline = sidx;
+    stat.utime = utime;
+    stat.stime = stime;
+    stat.has_cpu_percent = cpuPercent >= 0;
+    stat.cpu_percent = cpuPercent >= 0 ? cpuPercent : 0;
+    return stat;
+}
+
+TopProcess topProcess(int32_t sidx, float cpuPercent, int32_t rssKib)
+{
+    TopProcess top = {};
+    top.sidx_comm = sidx;
+    top.has_cpu_percent = cpuPercent >= 0;
+    top.cpu_percent = cpuPercent >= 0 ? cpuPercent : 0;
+    top.rss_kib = rssKib;
+    return top;
+}
+
+} // namespace
+
+TEST(EncodeSnapshot, matchesPbEncode)
+{
+    const std::vector<std::string_view> strs = {
+        "/usr/bin/ipmid (ipmid)", "/sbin/init (systemd)", "",
+        "/usr/bin/some-daemon --instance=300 (some-daemon)"};
+    const std::vector<ProcStat> procs = {
+        procStat(0, 12.5f, 3.25f, 1.5f),
+        procStat(1, 0.5f, 0.25f, -1),
+    };
+    const std::vector<FdStat> fds = {
+        {.sidx_cmdline = 0, .fd_count = 42},
+        {.sidx_cmdline = 3, .fd_count = 7},
+    };
+    // Column values cover negative deltas, varints longer than one byte and
+    // a column left empty.
+    const std::vector<int32_t> sidxDeltas = {3, -2, 1, -1};
+    const std::vector<uint64_t> utimeTicks = {1, 300, 1ull << 40, 0};
+    const std::vector<uint64_t> stimeTicks = {0, 127, 128, 16384};
+    const std::vector<float> cpuPercent = {-1, 0, 12.5f, 100};
+    const std::vector<float> noDelays;
+    const std::vector<int32_t> fdDeltas = {0, 3};
+    const std::vector<uint32_t> fdCounts = {42, 70000};
+
+    bmcmetrics_metricproto_BmcMetricSnapshot snapshot = {};
+    snapshot.has_string_table = true;
+    snapshot.string_table = stringTable(strs);
+    snapshot.has_memory_metric = true;
+    snapshot.memory_metric = {
+        .mem_available = 500000, .slab = 20000, .kernel_stack = 2000};
+    snapshot.has_procstat_metric = true;
+    snapshot.procstat_metric.stats = metric_blob::pbSubsEncoder<
+        bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat_fields>(procs);
+    snapshot.procstat_metric.has_cpu_interval_sec = true;
+    snapshot.procstat_metric.cpu_interval_sec = 10;
+    snapshot.procstat_metric.sidx_cmdline_delta =
+        metric_blob::pbPackedEncoder(sidxDeltas);
+    snapshot.procstat_metric.utime_ticks =
+        metric_blob::pbPackedEncoder(utimeTicks);
+    snapshot.procstat_metric.stime_ticks =
+        metric_blob::pbPackedEncoder(stimeTicks);
+    snapshot.procstat_metric.has_ticks_per_sec = true;
+    snapshot.procstat_metric.ticks_per_sec = 100;
+    snapshot.procstat_metric.cpu_percent =
+        metric_blob::pbPackedEncoder(cpuPercent);
+    snapshot.procstat_metric.cpu_delay = metric_blob::pbPackedEncoder(noDelays);
+    snapshot.has_fdstat_metric = true;
+    snapshot.fdstat_metric.stats = metric_blob::pbSubsEncoder<
+        bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat_fields>(fds);
+    snapshot.fdstat_metric.sidx_cmdline_delta =
+        metric_blob::pbPackedEncoder(fdDeltas);
+    snapshot.fdstat_metric.fd_count = metric_blob::pbPackedEncoder(fdCounts);
+
+    std::vector<char> out;
+    const char* error = nullptr;
+    ASSERT_TRUE(metric_blob::encodeSnapshot(snapshot, out, error));
+    EXPECT_EQ(out, encodeTwoPass(
+                       bmcmetrics_metricproto_BmcMetricSnapshot_fields,
+                       &snapshot));
+
+    std::vector<std::string> decodedStrs;
+    std::vector<ProcStat> decodedProcs;
+    std::vector<FdStat> decodedFds;
+    std::vector<int32_t> decodedSidxDeltas;
+    std::vector<uint64_t> decodedUtimeTicks;
+    std::vector<uint64_t> decodedStimeTicks;
+    std::vector<float> decodedCpuPercent;
+    std::vector<float> decodedCpuDelay;
+    std::vector<int32_t> decodedFdDeltas;
+    std::vector<uint32_t> decodedFdCounts;
+    bmcmetrics_metricproto_BmcMetricSnapshot decoded = {};
+    decoded.string_table.entries = stringEntriesDecoder(decodedStrs);
+    decoded.procstat_metric.stats = subsDecoder<
+        bmcmetrics_metricproto_BmcProcStatMetric_BmcProcStat_fields>(
+        decodedProcs);
+    decoded.procstat_metric.sidx_cmdline_delta =
+        scalarsDecoder(decodedSidxDeltas);
+    decoded.procstat_metric.utime_ticks = scalarsDecoder(decodedUtimeTicks);
+    decoded.procstat_metric.stime_ticks = scalarsDecoder(decodedStimeTicks);
+    decoded.procstat_metric.cpu_percent = scalarsDecoder(decodedCpuPercent);
+    decoded.procstat_metric.cpu_delay = scalarsDecoder(decodedCpuDelay);
+    decoded.fdstat_metric.stats =
+        subsDecoder<bmcmetrics_metricproto_BmcFdStatMetric_BmcFdStat_fields>(
+            decodedFds);
+    decoded.fdstat_metric.sidx_cmdline_delta = scalarsDecoder(decodedFdDeltas);
+    decoded.fdstat_metric.fd_count = scalarsDecoder(decodedFdCounts);
+    pb_istream_t stream = istream(out);
+    ASSERT_TRUE(pb_decode(
+        &stream, bmcmetrics_metricproto_BmcMetricSnapshot_fields, &decoded));
+
+    EXPECT_EQ(decodedStrs, std::vector<std::string>(strs.begin(), strs.end()));
+    EXPECT_TRUE(decoded.has_memory_metric);
+    EXPECT_EQ(decoded.memory_metric.mem_available, 500000);
+    EXPECT_EQ(decoded.memory_metric.slab, 20000);
+    EXPECT_EQ(decoded.memory_metric.kernel_stack, 2000);
+    EXPECT_FALSE(decoded.has_uptime_metric);
+
+    ASSERT_TRUE(decoded.has_procstat_metric);
+    ASSERT_EQ(decodedProcs.size(), procs.size());
+    for (size_t i = 0; i < procs.size(); ++i)
+    {
+        EXPECT_EQ(decodedProcs[i].sidx_cmdline, procs[i].sidx_cmdline);
+        EXPECT_EQ(decodedProcs[i].utime, procs[i].utime);
+        EXPECT_EQ(decodedProcs[i].stime, procs[i].stime);
+        EXPECT_EQ(decodedProcs[i].has_cpu_percent, procs[i].has_cpu_percent);
+        EXPECT_EQ(decodedProcs[i].cpu_percent, procs[i].cpu_percent);
+    }
+    EXPECT_TRUE(decoded.procstat_metric.has_cpu_interval_sec);
+    EXPECT_EQ(decoded.procstat_metric.cpu_interval_sec, 10);
+    EXPECT_EQ(decodedSidxDeltas, sidxDeltas);
+    EXPECT_EQ(decodedUtimeTicks, utimeTicks);
+    EXPECT_EQ(decodedStimeTicks, stimeTicks);
+    EXPECT_TRUE(decoded.procstat_metric.has_ticks_per_sec);
+    EXPECT_EQ(decoded.procstat_metric.ticks_per_sec, 100);
+    EXPECT_EQ(decodedCpuPercent, cpuPercent);
+    EXPECT_TRUE(decodedCpuDelay.empty());
+
+    ASSERT_TRUE(decoded.has_fdstat_metric);
+    ASSERT_EQ(decodedFds.size(), fds.size());
+    for (size_t i = 0; i < fds.size(); ++i)
+    {
+        EXPECT_EQ(decodedFds[i].sidx_cmdline, fds[i].sidx_cmdline);
+        EXPECT_EQ(decodedFds[i].fd_count, fds[i].fd_count);
+    }
+    EXPECT_EQ(decodedFdDeltas, fdDeltas);
+    EXPECT_EQ(decodedFdCounts, fdCounts);
+}
+
+TEST(EncodeSnapshot, empty)
+{
+    bmcmetrics_metricproto_BmcMetricSnapshot snapshot = {};
+    std::vector<char> out = {'x'};
+    const char* error = nullptr;
+    ASSERT_TRUE(metric_blob::encodeSnapshot(snapshot, out, error));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(EncodeHistory, matchesPbEncode)
+{
+    const std::vector<std::string_view> strs = {"(ipmid)", "(systemd)"};
+    const std::vector<std::vector<TopProcess>> top = {
+        {topProcess(0, 25, 4096), topProcess(1, -1, 8192)},
+        {},
+    };
+    std::vector<Sample> samples(2, Sample{});
+    samples[0].uptime = 100;
+    samples[0].mem_available = 300000;
+    samples[0].has_cpu_busy_percent = true;
+    samples[0].cpu_busy_percent = 40;
+    samples[0].has_io_full_avg10 = true;
+    samples[0].io_full_avg10 = 0.5f;
+    samples[1].uptime = 110;
+    samples[1].mem_available = 290000;
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        samples[i].top_processes = metric_blob::pbSubsEncoder<
+            bmcmetrics_metricproto_BmcMetricHistory_TopProcess_fields>(top[i]);
+    }
+    const bmcmetrics_metricproto_BmcStringTable table = stringTable(strs);
+
+    std::vector<char> out;
+    const char* error = nullptr;
+    ASSERT_TRUE(metric_blob::encodeHistory(table, samples, out, error));
+    const bmcmetrics_metricproto_BmcMetricHistory history = {
+        .has_string_table = true,
+        .string_table = table,
+        .samples = metric_blob::pbSubsEncoder<
+            bmcmetrics_metricproto_BmcMetricHistory_Sample_fields>(samples),
+    };
+    EXPECT_EQ(out, encodeTwoPass(bmcmetrics_metricproto_BmcMetricHistory_fields,
+                                 &history));
+
+    // Samples are decoded one at a time, so that each gets its own vector of
+    // top processes.
+    struct DecodedSample
+    {
+        Sample sample;
+        std::vector<TopProcess> top;
+    };
+    static constexpr auto decodeSample = [](pb_istream_t* stream,
+                                            const pb_field_t*, void** arg) {
+        auto& decodedSamples =
+            *reinterpret_cast<std::vector<DecodedSample>*>(*arg);
+        DecodedSample& s = decodedSamples.emplace_back();
+        s.sample.top_processes = subsDecoder<
+            bmcmetrics_metricproto_BmcMetricHistory_TopProcess_fields>(s.top);
+        return pb_decode(
+            stream, bmcmetrics_metricproto_BmcMetricHistory_Sample_fields,
+            &s.sample);
+    };
+    std::vector<std::string> decodedStrs;
+    std::vector<DecodedSample> decodedSamples;
+    decodedSamples.reserve(samples.size());
+    bmcmetrics_metricproto_BmcMetricHistory decoded = {};
+    decoded.string_table.entries = stringEntriesDecoder(decodedStrs);
+    decoded.samples = {{.decode = decodeSample}, &decodedSamples};
+    pb_istream_t stream = istream(out);
+    ASSERT_TRUE(pb_decode(
+        &stream, bmcmetrics_metricproto_BmcMetricHistory_fields, &decoded));
+
+    EXPECT_EQ(decodedStrs, std::vector<std::string>(strs.begin(), strs.end()));
+    ASSERT_EQ(decodedSamples.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const Sample& s = decodedSamples[i].sample;
+        EXPECT_EQ(s.uptime, samples[i].uptime);
+        EXPECT_EQ(s.mem_available, samples[i].mem_available);
+        EXPECT_EQ(s.has_cpu_busy_percent, samples[i].has_cpu_busy_percent);
+        EXPECT_EQ(s.cpu_busy_percent, samples[i].cpu_busy_percent);
+        EXPECT_EQ(s.has_io_full_avg10, samples[i].has_io_full_avg10);
+        EXPECT_EQ(s.io_full_avg10, samples[i].io_full_avg10);
+        ASSERT_EQ(decodedSamples[i].top.size(), top[i].size());
+        for (size_t p = 0; p < top[i].size(); ++p)
+        {
+            const TopProcess& t = decodedSamples[i].top[p];
+            EXPECT_EQ(t.sidx_comm, top[i][p].sidx_comm);
+            EXPECT_EQ(t.has_cpu_percent, top[i][p].has_cpu_percent);
+            EXPECT_EQ(t.cpu_percent, top[i][p].cpu_percent);
+            EXPECT_EQ(t.rss_kib, top[i][p].rss_kib);
+        }
+    }
+}
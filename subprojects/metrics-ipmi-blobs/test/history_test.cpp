@@ -0,0 +1,63 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "history.hpp"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+metric_blob::HistoryRecord makeRecord(float uptime)
+{
+    metric_blob::HistoryRecord record;
+    record.uptime = uptime;
+    return record;
+}
+
+std::vector<float> uptimes(const metric_blob::MetricHistory& history)
+{
+    std::vector<float> ret;
+    for (const auto& record : history.records())
+    {
+        ret.push_back(record.uptime);
+    }
+    return ret;
+}
+
+} // namespace
+
+TEST(MetricHistory, keepsLastRecordsOldestFirst)
+{
+    metric_blob::MetricHistory history(3);
+    EXPECT_TRUE(history.records().empty());
+
+    history.add(makeRecord(1));
+    history.add(makeRecord(2));
+    EXPECT_EQ(uptimes(history), (std::vector<float>{1, 2}));
+
+    history.add(makeRecord(3));
+    history.add(makeRecord(4));
+    history.add(makeRecord(5));
+    EXPECT_EQ(uptimes(history), (std::vector<float>{3, 4, 5}));
+}
+
+TEST(MetricHistory, disabled)
+{
+    metric_blob::MetricHistory history(0);
+    history.add(makeRecord(1));
+    EXPECT_TRUE(history.records().empty());
+}
@@ -0,0 +1,148 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lz4.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// Minimal LZ4 block decoder, failing on any out of bounds access.
+std::optional<std::string> decompress(const std::vector<char>& block)
+{
+    std::string out;
+    size_t pos = 0;
+    auto length = [&](size_t base) -> std::optional<size_t> {
+        if (base < 15)
+        {
+            return base;
+        }
+        uint8_t b;
+        do
+        {
+            if (pos >= block.size())
+            {
+                return std::nullopt;
+            }
+            b = static_cast<uint8_t>(block[pos++]);
+            base += b;
+        } while (b == 255);
+        return base;
+    };
+    while (pos < block.size())
+    {
+        uint8_t token = static_cast<uint8_t>(block[pos++]);
+        auto literals = length(token >> 4);
+        if (!literals || block.size() - pos < *literals)
+        {
+            return std::nullopt;
+        }
+        out.append(block.data() + pos, *literals);
+        pos += *literals;
+        if (pos == block.size())
+        {
+            return out;
+        }
+        if (block.size() - pos < 2)
+        {
+            return std::nullopt;
+        }
+        size_t offset = static_cast<uint8_t>(block[pos]) |
+                        static_cast<uint8_t>(block[pos + 1]) << 8;
+        pos += 2;
+        auto match = length(token & 0xf);
+        if (!match || offset == 0 || offset > out.size())
+        {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < *match + 4; ++i)
+        {
+            out.push_back(out[out.size() - offset]);
+        }
+    }
+    return std::nullopt;
+}
+
+void expectRoundTrip(std::string_view data)
+{
+    auto block = metric_blob::lz4CompressBlock(data);
+    auto out = decompress(block);
+    ASSERT_TRUE(out.has_value());
+    EXPECT_EQ(*out, data);
+}
+
+} // namespace
+
+TEST(Lz4CompressBlock, empty)
+{
+    auto block = metric_blob::lz4CompressBlock("");
+    EXPECT_EQ(block, std::vector<char>{0});
+}
+
+TEST(Lz4CompressBlock, shortInputsAreLiterals)
+{
+    for (std::string_view s : {"a", "aaaa", "abcdabcdabc", "aaaaaaaaaaaa"})
+    {
+        auto block = metric_blob::lz4CompressBlock(s);
+        EXPECT_EQ(block.size(), s.size() + 1) << s;
+        expectRoundTrip(s);
+    }
+}
+
+TEST(Lz4CompressBlock, roundTrips)
+{
+    expectRoundTrip(std::string(13, 'x'));
+    expectRoundTrip(std::string(100000, 'x'));
+    expectRoundTrip("/usr/bin/ipmid /usr/bin/ipmid --flag /usr/bin/ipmid");
+
+    // Pseudo-random bytes with repeats at every distance, including ones
+    // beyond the 64 KiB window.
+    std::string data;
+    uint32_t x = 1;
+    for (int i = 0; i < 200000; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        if (x % 7 == 0 && data.size() > 70000)
+        {
+            size_t from = (x >> 8) % (data.size() - 16);
+            data.append(data, from, (x >> 4) % 300);
+        }
+        else
+        {
+            data.push_back(static_cast<char>(x >> 24));
+        }
+    }
+    expectRoundTrip(data);
+}
+
+TEST(Lz4CompressBlock, compressesRepetitiveData)
+{
+    std::string data;
+    for (int i = 0; i < 50; ++i)
+    {
+        data += "/usr/libexec/phosphor-sensor-" + std::to_string(i % 5) + ";";
+    }
+    auto block = metric_blob::lz4CompressBlock(data);
+    EXPECT_LT(block.size() * 4, data.size());
+    expectRoundTrip(data);
+}
@@ -0,0 +1,58 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metric.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+std::vector<metric_blob::ProcessInfo> oneProcess()
+{
+    metric_blob::ProcessInfo info;
+    info.pid = 1;
+    info.starttime = 1;
+    return {info};
+}
+
+} // namespace
+
+TEST(CollectionState, sectionsKeepTheirOwnRates)
+{
+    using namespace std::chrono_literals;
+    metric_blob::CollectionState state;
+    const std::chrono::steady_clock::time_point start;
+    auto processes = oneProcess();
+
+    metric_blob::RateTrackers& all =
+        state.ratesFor(metric_blob::section::all);
+    EXPECT_EQ(all.processes.update(processes, 100, start), 0);
+
+    // Polling the procstat section in between is its own first collection,
+    // and leaves the interval of the next complete snapshot alone.
+    metric_blob::RateTrackers& procstat =
+        state.ratesFor(metric_blob::section::procstat);
+    EXPECT_NE(&procstat, &all);
+    EXPECT_EQ(procstat.processes.update(processes, 100, start + 2s), 0);
+
+    EXPECT_EQ(&state.ratesFor(metric_blob::section::all), &all);
+    EXPECT_FLOAT_EQ(all.processes.update(processes, 100, start + 10s), 10);
+    EXPECT_FLOAT_EQ(state.ratesFor(metric_blob::section::procstat)
+                        .processes.update(processes, 100, start + 13s),
+                    11);
+}
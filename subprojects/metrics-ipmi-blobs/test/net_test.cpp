@@ -0,0 +1,85 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "net.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(CollectNetDevs, findsLoopback)
+{
+    metric_blob::ProcFileReader reader;
+    auto netDevs = metric_blob::collectNetDevs(reader);
+    auto lo = std::find_if(netDevs.begin(), netDevs.end(),
+                           [](const auto& d) { return d.name == "lo"; });
+    ASSERT_NE(lo, netDevs.end());
+    EXPECT_LT(lo->rxBytesPerSec, 0);
+}
+
+TEST(NetDevRateTracker, ratesSincePreviousUpdate)
+{
+    using namespace std::chrono_literals;
+    metric_blob::NetDevRateTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<metric_blob::NetDevInfo> netDevs = {
+        {"eth0", {.rxBytes = 1000, .rxPackets = 10, .txBytes = 500}},
+        {"eth1", {.rxBytes = 5000}},
+    };
+    EXPECT_EQ(tracker.update(netDevs, t0), 0);
+    EXPECT_LT(netDevs[0].rxBytesPerSec, 0);
+
+    // Over 10 s: eth0 received 2000 bytes in 20 packets, eth1 was re-created
+    // and its counters restarted, and usb0 is new.
+    netDevs = {
+        {"eth0", {.rxBytes = 3000, .rxPackets = 30, .txBytes = 500}},
+        {"eth1", {.rxBytes = 100}},
+        {"usb0", {.txBytes = 50}},
+    };
+    EXPECT_FLOAT_EQ(tracker.update(netDevs, t0 + 10s), 10);
+    EXPECT_FLOAT_EQ(netDevs[0].rxBytesPerSec, 200);
+    EXPECT_FLOAT_EQ(netDevs[0].rxPacketsPerSec, 2);
+    EXPECT_FLOAT_EQ(netDevs[0].txBytesPerSec, 0);
+    EXPECT_FLOAT_EQ(netDevs[1].rxBytesPerSec, 10);
+    EXPECT_FLOAT_EQ(netDevs[2].txBytesPerSec, 5);
+}
+
+TEST(NetDevRateTracker, dropsRemovedInterfaces)
+{
+    using namespace std::chrono_literals;
+    metric_blob::NetDevRateTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<metric_blob::NetDevInfo> netDevs = {
+        {"eth0", {.rxBytes = 1000}},
+        {"usb0", {.rxBytes = 1000}},
+    };
+    tracker.update(netDevs, t0);
+    netDevs = {{"eth0", {.rxBytes = 2000}}};
+    tracker.update(netDevs, t0 + 10s);
+    EXPECT_FLOAT_EQ(netDevs[0].rxBytesPerSec, 100);
+
+    // usb0 came back, and is counted from zero rather than from its
+    // counters from before it was removed.
+    netDevs = {
+        {"eth0", {.rxBytes = 2000}},
+        {"usb0", {.rxBytes = 1500}},
+    };
+    tracker.update(netDevs, t0 + 20s);
+    EXPECT_FLOAT_EQ(netDevs[0].rxBytesPerSec, 0);
+    EXPECT_FLOAT_EQ(netDevs[1].rxBytesPerSec, 150);
+}
@@ -0,0 +1,212 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace
+{
+
+constexpr std::string_view statLine =
+    "2596 (dbus-broker) R 2577 2577 2577 0 -1 4194560 299 0 1 0 333037 246110 "
+    "0 0 20 0 1 0 1545 3411968 530 4294967295 65536 246512 2930531712 0 0 0 "
+    "81923 4 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n";
+
+struct LegacyStat
+{
+    std::string tcomm;
+    float utime;
+    float stime;
+};
+
+// The strtok-based parser this benchmark was written to replace, kept as the
+// baseline.
+LegacyStat legacyParse(std::string_view content, long ticksPerSec)
+{
+    LegacyStat ret;
+    ret.utime = ret.stime = 0;
+    const float invTicksPerSec = 1.0f / static_cast<float>(ticksPerSec);
+    std::string temp(content);
+    char* pCol = strtok(temp.data(), " ");
+    for (int colIdx = 0; pCol != nullptr && colIdx < 15; ++colIdx)
+    {
+        if (colIdx == 1)
+        {
+            ret.tcomm = std::string(pCol);
+        }
+        else if (colIdx == 13)
+        {
+            ret.utime = static_cast<float>(std::atoi(pCol)) * invTicksPerSec;
+        }
+        else if (colIdx == 14)
+        {
+            ret.stime = static_cast<float>(std::atoi(pCol)) * invTicksPerSec;
+        }
+        pCol = strtok(nullptr, " ");
+    }
+    return ret;
+}
+
+void BM_StatLegacyStrtok(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(legacyParse(statLine, 100));
+    }
+}
+BENCHMARK(BM_StatLegacyStrtok);
+
+void BM_StatProcPidStatAllFields(benchmark::State& state)
+{
+    metric_blob::ProcPidStat stat;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(stat.parse(statLine));
+        benchmark::DoNotOptimize(stat.number(metric_blob::ProcPidStat::utime));
+        benchmark::DoNotOptimize(stat.number(metric_blob::ProcPidStat::stime));
+    }
+}
+BENCHMARK(BM_StatProcPidStatAllFields);
+
+// Holds open enough descriptors to look like a busy daemon for the duration of
+// a benchmark.
+class ManyFds
+{
+  public:
+    explicit ManyFds(size_t n)
+    {
+        rlimit rl;
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < n + 64 &&
+            rl.rlim_max >= n + 64)
+        {
+            rl.rlim_cur = n + 64;
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            int fd = dup(STDERR_FILENO);
+            if (fd < 0)
+            {
+                break;
+            }
+            fds.push_back(fd);
+        }
+    }
+    ~ManyFds()
+    {
+        for (int fd : fds)
+        {
+            close(fd);
+        }
+    }
+    size_t size() const
+    {
+        return fds.size();
+    }
+
+  private:
+    std::vector<int> fds;
+};
+
+constexpr size_t manyFds = 10000;
+
+void BM_FdCountDirectoryIterator(benchmark::State& state)
+{
+    ManyFds fds(manyFds);
+    if (fds.size() < manyFds)
+    {
+        state.SkipWithError("Could not open enough descriptors");
+        return;
+    }
+    const std::string path = "/proc/" + std::to_string(getpid()) + "/fd";
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            std::distance(std::filesystem::directory_iterator(path),
+                          std::filesystem::directory_iterator{}));
+    }
+}
+BENCHMARK(BM_FdCountDirectoryIterator);
+
+void BM_FdCountGetdents(benchmark::State& state)
+{
+    ManyFds fds(manyFds);
+    if (fds.size() < manyFds)
+    {
+        state.SkipWithError("Could not open enough descriptors");
+        return;
+    }
+    metric_blob::FdCounter counter;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(counter.countEntries(getpid()));
+    }
+}
+BENCHMARK(BM_FdCountGetdents);
+
+// Only differs from BM_FdCountGetdents on Linux 6.2 and later.
+void BM_FdCountStatSize(benchmark::State& state)
+{
+    ManyFds fds(manyFds);
+    if (fds.size() < manyFds)
+    {
+        state.SkipWithError("Could not open enough descriptors");
+        return;
+    }
+    metric_blob::FdCounter counter;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(counter.count(getpid()));
+    }
+}
+BENCHMARK(BM_FdCountStatSize);
+
+void BM_StatReadOpenClose(benchmark::State& state)
+{
+    metric_blob::ProcFileReader reader;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(reader.read(getpid(), "stat"));
+    }
+}
+BENCHMARK(BM_StatReadOpenClose);
+
+void BM_StatPreadOpenFd(benchmark::State& state)
+{
+    metric_blob::ProcFileReader reader;
+    int fd = metric_blob::openProcPidFile(getpid(), "stat");
+    int error;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(reader.pread(fd, error));
+    }
+    close(fd);
+}
+BENCHMARK(BM_StatPreadOpenFd);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,408 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proc.hpp"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+metric_blob::ProcessInfo makeProcess(int pid, uint64_t starttime,
+                                     uint64_t utimeTicks, uint64_t stimeTicks)
+{
+    metric_blob::ProcessInfo info;
+    info.pid = pid;
+    info.starttime = starttime;
+    info.utimeTicks = utimeTicks;
+    info.stimeTicks = stimeTicks;
+    return info;
+}
+
+} // namespace
+
+TEST(CollectProcesses, findsSelf)
+{
+    metric_blob::ProcFileReader reader;
+    auto processes = metric_blob::collectProcesses(reader, 100);
+    auto self = std::find_if(processes.begin(), processes.end(),
+                             [](const auto& p) { return p.pid == getpid(); });
+    ASSERT_NE(self, processes.end());
+    EXPECT_FALSE(self->cmdline.empty());
+    EXPECT_TRUE(self->tcomm.starts_with("("));
+    EXPECT_GT(self->fdCount, 0);
+    EXPECT_GT(self->starttime, 0);
+    EXPECT_GT(self->rssKib, 0);
+    EXPECT_TRUE(self->hasIo);
+}
+
+TEST(ProcFileCache, keepsFilesOfLiveProcesses)
+{
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcFileCache files(100);
+    metric_blob::collectProcesses(reader, 100, {.files = &files});
+    EXPECT_GT(files.size(), 0);
+    EXPECT_LE(files.size(), 100);
+
+    // The same reads go through the open files, and produce the same names.
+    auto second =
+        metric_blob::collectProcesses(reader, 100, {.files = &files});
+    auto self = std::find_if(second.begin(), second.end(),
+                             [](const auto& p) { return p.pid == getpid(); });
+    ASSERT_NE(self, second.end());
+    EXPECT_FALSE(self->cmdline.empty());
+    EXPECT_TRUE(self->tcomm.starts_with("("));
+    EXPECT_GT(self->rssKib, 0);
+    EXPECT_TRUE(self->hasIo);
+}
+
+TEST(ProcFileCache, dropsExitedProcesses)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        char c;
+        close(fds[1]);
+        _exit(read(fds[0], &c, 1) < 0);
+    }
+    close(fds[0]);
+
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcFileCache files(1000);
+    EXPECT_FALSE(
+        files.read(reader, child, metric_blob::ProcFileCache::stat).empty());
+    EXPECT_EQ(files.size(), 1);
+
+    close(fds[1]);
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    EXPECT_TRUE(
+        files.read(reader, child, metric_blob::ProcFileCache::stat).empty());
+    EXPECT_EQ(files.size(), 0);
+
+    // Processes not read during a snapshot are dropped at its end.
+    EXPECT_FALSE(
+        files.read(reader, getpid(), metric_blob::ProcFileCache::io).empty());
+    files.endSnapshot();
+    EXPECT_EQ(files.size(), 1);
+    files.endSnapshot();
+    EXPECT_EQ(files.size(), 0);
+}
+
+TEST(ProcFileCache, doesNotKeepUnopenedProcesses)
+{
+    // Past pid_max, so never a live process.
+    constexpr int missing = 1 << 23;
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcFileCache files(1000);
+    std::string_view content =
+        files.read(reader, missing, metric_blob::ProcFileCache::stat);
+    EXPECT_TRUE(content.empty());
+    EXPECT_NE(content.data(), nullptr);
+    EXPECT_EQ(reader.error(), ENOENT);
+    EXPECT_EQ(files.size(), 0);
+}
+
+TEST(ProcessTable, followsForkAndExit)
+{
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcessTable table;
+    if (!table.update(reader))
+    {
+        GTEST_SKIP() << "Process events need CAP_NET_ADMIN";
+    }
+    ASSERT_TRUE(table.entries().contains(getpid()));
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        // Wait for the parent to close its end before exiting.
+        char c;
+        close(fds[1]);
+        _exit(read(fds[0], &c, 1) < 0);
+    }
+    close(fds[0]);
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_TRUE(table.entries().contains(child));
+    auto processes = metric_blob::collectProcesses(
+        reader, 100, {.countFds = false, .table = &table});
+    auto self = std::find_if(processes.begin(), processes.end(),
+                             [](const auto& p) { return p.pid == getpid(); });
+    ASSERT_NE(self, processes.end());
+    EXPECT_FALSE(self->cmdline.empty());
+    EXPECT_TRUE(self->tcomm.starts_with("("));
+
+    close(fds[1]);
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_FALSE(table.entries().contains(child));
+}
+
+TEST(ProcessTable, dropsZombies)
+{
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcessTable table;
+    if (!table.update(reader))
+    {
+        GTEST_SKIP() << "Process events need CAP_NET_ADMIN";
+    }
+
+    // The fork and exit events of the child arrive in the same update, while
+    // the child is a zombie whose stat is still readable.
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        _exit(0);
+    }
+    siginfo_t info;
+    ASSERT_EQ(waitid(P_PID, child, &info, WEXITED | WNOWAIT), 0);
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_FALSE(table.entries().contains(child));
+
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_FALSE(table.entries().contains(child));
+}
+
+TEST(ProcessTable, keepsProcessesWhoseLeaderExited)
+{
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcessTable table;
+    if (!table.update(reader))
+    {
+        GTEST_SKIP() << "Process events need CAP_NET_ADMIN";
+    }
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        // The main thread exits, and a second one waits for the parent to
+        // close its end of the pipe.
+        close(fds[1]);
+        pthread_t thread;
+        pthread_create(
+            &thread, nullptr,
+            [](void* arg) -> void* {
+                char c;
+                _exit(read(*static_cast<int*>(arg), &c, 1) < 0);
+            },
+            &fds[0]);
+        // Unlike pthread_exit(), which unwinds into the test framework.
+        syscall(SYS_exit, 0);
+    }
+    close(fds[0]);
+
+    // Wait for the leader to become a zombie.
+    metric_blob::ProcPidStat stat;
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (stat.parse(reader.read(child, "stat"),
+                       metric_blob::ProcPidStat::state) &&
+            stat.field(metric_blob::ProcPidStat::state) == "Z")
+        {
+            break;
+        }
+        usleep(1000);
+    }
+    ASSERT_EQ(stat.field(metric_blob::ProcPidStat::state), "Z");
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_TRUE(table.entries().contains(child));
+
+    close(fds[1]);
+    siginfo_t info;
+    ASSERT_EQ(waitid(P_PID, child, &info, WEXITED | WNOWAIT), 0);
+    ASSERT_TRUE(table.update(reader));
+    EXPECT_FALSE(table.entries().contains(child));
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+}
+
+TEST(ProcessTable, dropsReapedProcesses)
+{
+    // A zombie is listed by the first walk of /proc, and its exit event was
+    // sent before the table subscribed, so only the failed read of its stat
+    // once it is reaped tells that it is gone.
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        _exit(0);
+    }
+    siginfo_t info;
+    ASSERT_EQ(waitid(P_PID, child, &info, WEXITED | WNOWAIT), 0);
+
+    metric_blob::ProcFileReader reader;
+    metric_blob::ProcessTable table;
+    if (!table.update(reader))
+    {
+        GTEST_SKIP() << "Process events need CAP_NET_ADMIN";
+    }
+    EXPECT_TRUE(table.entries().contains(child));
+
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    metric_blob::collectProcesses(reader, 100,
+                                  {.countFds = false, .table = &table});
+    EXPECT_FALSE(table.entries().contains(child));
+}
+
+TEST(TaskStatsClient, queriesSelf)
+{
+    metric_blob::TaskStatsClient taskstats;
+    if (!taskstats.available())
+    {
+        GTEST_SKIP() << "Kernel built without taskstats";
+    }
+    metric_blob::TaskStats stats;
+    EXPECT_TRUE(taskstats.query(getpid(), stats));
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    EXPECT_FALSE(taskstats.query(child, stats));
+
+    metric_blob::ProcFileReader reader;
+    auto processes = metric_blob::collectProcesses(
+        reader, 100, {.countFds = false, .taskstats = &taskstats});
+    auto self = std::find_if(processes.begin(), processes.end(),
+                             [](const auto& p) { return p.pid == getpid(); });
+    ASSERT_NE(self, processes.end());
+    EXPECT_TRUE(self->hasDelays);
+}
+
+TEST(ProcessRateTracker, firstUpdateHasNoRates)
+{
+    metric_blob::ProcessRateTracker tracker;
+    std::vector<metric_blob::ProcessInfo> procs = {makeProcess(1, 5, 10, 10)};
+    EXPECT_EQ(tracker.update(procs, 100, std::chrono::steady_clock::now()),
+              0);
+    EXPECT_LT(procs[0].cpuPercent, 0);
+}
+
+TEST(ProcessRateTracker, ratesSincePreviousUpdate)
+{
+    using namespace std::chrono_literals;
+    metric_blob::ProcessRateTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<metric_blob::ProcessInfo> procs = {
+        makeProcess(1, 5, 1000, 1000),
+        makeProcess(2, 6, 500, 0),
+        makeProcess(3, 7, 10, 0),
+    };
+    tracker.update(procs, 100, t0);
+
+    // Over 10 s at 100 ticks/s: pid 1 used 500 ticks (50%), pid 2 none, pid 3
+    // was replaced by a new process with the same pid that used 20 ticks, and
+    // pid 4 is new and used 100 ticks.
+    procs = {
+        makeProcess(1, 5, 1300, 1200),
+        makeProcess(2, 6, 500, 0),
+        makeProcess(3, 900, 20, 0),
+        makeProcess(4, 950, 50, 50),
+    };
+    EXPECT_FLOAT_EQ(tracker.update(procs, 100, t0 + 10s), 10);
+    EXPECT_FLOAT_EQ(procs[0].cpuPercent, 50);
+    EXPECT_FLOAT_EQ(procs[1].cpuPercent, 0);
+    EXPECT_FLOAT_EQ(procs[2].cpuPercent, 2);
+    EXPECT_FLOAT_EQ(procs[3].cpuPercent, 10);
+
+    // Rates are relative to the latest update only.
+    procs = {makeProcess(1, 5, 1300, 1250)};
+    EXPECT_FLOAT_EQ(tracker.update(procs, 100, t0 + 15s), 5);
+    EXPECT_FLOAT_EQ(procs[0].cpuPercent, 10);
+}
+
+TEST(ProcessRateTracker, tickSourceChanges)
+{
+    using namespace std::chrono_literals;
+    metric_blob::ProcessRateTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    auto fromTaskstats = [](metric_blob::ProcessInfo info) {
+        info.taskstatsTicks = true;
+        return info;
+    };
+    std::vector<metric_blob::ProcessInfo> procs = {
+        fromTaskstats(makeProcess(1, 5, 1000, 1000))};
+    tracker.update(procs, 100, t0);
+
+    // A failed taskstats query falls back to stat, whose ticks are slightly
+    // lower: no rate instead of the lifetime ticks as one interval's.
+    procs = {makeProcess(1, 5, 990, 990)};
+    tracker.update(procs, 100, t0 + 10s);
+    EXPECT_LT(procs[0].cpuPercent, 0);
+
+    // Switching back restarts from the stat sample as well.
+    procs = {fromTaskstats(makeProcess(1, 5, 1100, 1000))};
+    tracker.update(procs, 100, t0 + 20s);
+    EXPECT_LT(procs[0].cpuPercent, 0);
+
+    procs = {fromTaskstats(makeProcess(1, 5, 1200, 1000))};
+    tracker.update(procs, 100, t0 + 30s);
+    EXPECT_FLOAT_EQ(procs[0].cpuPercent, 10);
+}
+
+TEST(ProcessRateTracker, writeRates)
+{
+    using namespace std::chrono_literals;
+    metric_blob::ProcessRateTracker tracker;
+    auto t0 = std::chrono::steady_clock::now();
+
+    auto withWrites = [](metric_blob::ProcessInfo info, uint64_t bytes) {
+        info.hasIo = true;
+        info.io.writeBytes = bytes;
+        return info;
+    };
+    std::vector<metric_blob::ProcessInfo> procs = {
+        withWrites(makeProcess(1, 5, 0, 0), 4096),
+        makeProcess(2, 6, 0, 0),
+    };
+    tracker.update(procs, 100, t0);
+    EXPECT_LT(procs[0].writeBytesPerSec, 0);
+
+    // Pid 1 wrote 40 KiB in 10 s, pid 2 has no I/O counters and pid 3 is
+    // new, so everything it wrote counts.
+    procs = {
+        withWrites(makeProcess(1, 5, 0, 0), 4096 + 40960),
+        makeProcess(2, 6, 0, 0),
+        withWrites(makeProcess(3, 7, 0, 0), 1000),
+    };
+    tracker.update(procs, 100, t0 + 10s);
+    EXPECT_FLOAT_EQ(procs[0].writeBytesPerSec, 4096);
+    EXPECT_LT(procs[1].writeBytesPerSec, 0);
+    EXPECT_FLOAT_EQ(procs[2].writeBytesPerSec, 100);
+}
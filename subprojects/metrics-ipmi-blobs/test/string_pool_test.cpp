@@ -0,0 +1,86 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "string_pool.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using metric_blob::StringPool;
+using ::testing::ElementsAre;
+
+TEST(StringPoolTest, idsInOrderOfFirstUse)
+{
+    StringPool pool;
+    pool.beginSnapshot();
+    EXPECT_EQ(pool.getStringID("b"), 0);
+    EXPECT_EQ(pool.getStringID("a"), 1);
+    // Lookups do not depend on the string being NUL-terminated.
+    std::string_view bc = "bc";
+    EXPECT_EQ(pool.getStringID(bc.substr(0, 1)), 0);
+    EXPECT_EQ(pool.getStringID(""), 2);
+    EXPECT_THAT(pool.strings(), ElementsAre("b", "a", ""));
+}
+
+TEST(StringPoolTest, idsArePerSnapshot)
+{
+    StringPool pool;
+    pool.beginSnapshot();
+    pool.getStringID("a");
+    pool.getStringID("b");
+
+    pool.beginSnapshot();
+    EXPECT_EQ(pool.getStringID("b"), 0);
+    EXPECT_THAT(pool.strings(), ElementsAre("b"));
+    // "a" stays interned for later snapshots.
+    EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(StringPoolTest, longStrings)
+{
+    StringPool pool;
+    pool.beginSnapshot();
+    std::string big(10000, 'x');
+    EXPECT_EQ(pool.getStringID("small"), 0);
+    EXPECT_EQ(pool.getStringID(big), 1);
+    EXPECT_EQ(pool.getStringID("small2"), 2);
+    EXPECT_THAT(pool.strings(), ElementsAre("small", big, "small2"));
+}
+
+TEST(StringPoolTest, dropsUnusedStrings)
+{
+    StringPool pool;
+    pool.beginSnapshot();
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.getStringID("process " + std::to_string(i));
+    }
+    pool.beginSnapshot();
+    pool.getStringID("process 42");
+    pool.getStringID("process 7");
+    EXPECT_EQ(pool.size(), 100u);
+
+    // Only what the previous snapshot used survives.
+    pool.beginSnapshot();
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_EQ(pool.getStringID("process 7"), 0);
+    EXPECT_EQ(pool.getStringID("process 1"), 1);
+    EXPECT_EQ(pool.getStringID("process 42"), 2);
+    EXPECT_THAT(pool.strings(),
+                ElementsAre("process 7", "process 1", "process 42"));
+}
@@ -0,0 +1,116 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "topk.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+struct Entry
+{
+    int value;
+    std::string name;
+};
+
+// Largest value first, then by name.
+auto entryKey(const Entry& e)
+{
+    return std::tuple<int, const std::string&>(-e.value, e.name);
+}
+
+// Ranks entries with a TopK and returns the names of the top k followed by
+// the sum of the folded values.
+std::pair<std::vector<std::string>, int> rank(const std::vector<Entry>& entries,
+                                              size_t k)
+{
+    int others = 0;
+    auto fold = [&](const Entry& e) { others += e.value; };
+    auto top = metric_blob::makeTopK<Entry>(k, entryKey, fold);
+    for (const Entry& e : entries)
+    {
+        top.add(e);
+    }
+    std::vector<std::string> names;
+    for (const Entry* e : top.take())
+    {
+        names.push_back(e->name);
+    }
+    return {names, others};
+}
+
+} // namespace
+
+TEST(TopK, keepsBestRankedInOrder)
+{
+    std::vector<Entry> entries = {
+        {3, "c"}, {7, "a"}, {1, "x"}, {7, "b"}, {5, "d"}, {2, "y"},
+    };
+    auto [names, others] = rank(entries, 3);
+    EXPECT_EQ(names, (std::vector<std::string>{"a", "b", "d"}));
+    EXPECT_EQ(others, 3 + 1 + 2);
+}
+
+TEST(TopK, fewerEntriesThanK)
+{
+    std::vector<Entry> entries = {{1, "a"}, {2, "b"}};
+    auto [names, others] = rank(entries, 10);
+    EXPECT_EQ(names, (std::vector<std::string>{"b", "a"}));
+    EXPECT_EQ(others, 0);
+}
+
+TEST(TopK, zeroFoldsEverything)
+{
+    std::vector<Entry> entries = {{1, "a"}, {2, "b"}};
+    auto [names, others] = rank(entries, 0);
+    EXPECT_TRUE(names.empty());
+    EXPECT_EQ(others, 3);
+}
+
+TEST(TopK, matchesFullSort)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 50);
+    std::vector<Entry> entries;
+    int total = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        entries.push_back({dist(gen), std::to_string(i)});
+        total += entries.back().value;
+    }
+
+    std::vector<Entry> sorted = entries;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Entry& a, const Entry& b) {
+                  return entryKey(a) < entryKey(b);
+              });
+    std::vector<std::string> expected;
+    int expectedTop = 0;
+    for (size_t i = 0; i < 10; ++i)
+    {
+        expected.push_back(sorted[i].name);
+        expectedTop += sorted[i].value;
+    }
+
+    auto [names, others] = rank(entries, 10);
+    EXPECT_EQ(names, expected);
+    EXPECT_EQ(others, total - expectedTop);
+}
@@ -14,8 +14,12 @@
 
 #include "util.hpp"
 
+#include <unistd.h>
+
+#include <cerrno>
 #include <filesystem>
 #include <fstream>
+#include <string>
 
 #include "gtest/gtest.h"
 
@@ -35,58 +39,157 @@ TEST(IsNumericPath, validNumericPath)
     EXPECT_EQ(id, 10000);
 }
 
-TEST(ReadFileThenGrepIntoString, goodFile)
+TEST(ProcFileReader, goodFile)
 {
     const std::string& fileName = "./test_file";
     std::ofstream ofs(fileName, std::ios::trunc);
     std::string_view content = "This is\ntest\tcontentt\n\n\n\n.\n\n##$#$";
     ofs << content;
     ofs.close();
-    std::string readContent = metric_blob::readFileThenGrepIntoString(fileName);
-    std::filesystem::remove(fileName);
+    metric_blob::ProcFileReader reader;
+    std::string_view readContent = reader.read(fileName.c_str());
     EXPECT_EQ(readContent, content);
+    EXPECT_EQ(readContent.data()[readContent.size()], '\0');
+    EXPECT_EQ(reader.error(), 0);
+    std::filesystem::remove(fileName);
 }
 
-TEST(ReadFileThenGrepIntoString, inexistentFile)
+TEST(ProcFileReader, inexistentFile)
 {
     const std::string& fileName = "./inexistent_file";
-    std::string readContent = metric_blob::readFileThenGrepIntoString(fileName);
+    metric_blob::ProcFileReader reader;
+    std::string_view readContent = reader.read(fileName.c_str());
     EXPECT_EQ(readContent, "");
+    ASSERT_NE(readContent.data(), nullptr);
+    EXPECT_EQ(readContent.data()[0], '\0');
+    EXPECT_EQ(reader.error(), ENOENT);
+
+    // A leaf too long for a /proc path is an error of its own, not a stale
+    // one.
+    EXPECT_EQ(reader.read(getpid(), std::string(100, 'x')), "");
+    EXPECT_EQ(reader.error(), ENAMETOOLONG);
+}
+
+TEST(ProcFileReader, largeFile)
+{
+    const std::string& fileName = "./test_file";
+    std::string content(10000, 'x');
+    std::ofstream ofs(fileName, std::ios::trunc);
+    ofs << content;
+    ofs.close();
+    metric_blob::ProcFileReader reader;
+    EXPECT_EQ(reader.read(fileName.c_str()), content);
+    std::filesystem::remove(fileName);
+}
+
+TEST(ProcFileReader, grep)
+{
+    const std::string& fileName = "./test_file";
+    std::ofstream ofs(fileName, std::ios::trunc);
+    ofs << "processor\t: 0\nHardware\t: NPCM7XX Chip family\nRevision\t: 0";
+    ofs.close();
+    metric_blob::ProcFileReader reader;
+    EXPECT_EQ(reader.read(fileName.c_str(), "Hardware"),
+              "Hardware\t: NPCM7XX Chip family\n");
+    EXPECT_EQ(reader.read(fileName.c_str(), "Revision"), "Revision\t: 0");
+    EXPECT_EQ(reader.read(fileName.c_str(), "nothing"), "");
+    std::filesystem::remove(fileName);
 }
 
-TEST(GetTcommUtimeStime, validInput)
+TEST(ProcFileReader, procPid)
 {
-    // ticks_per_sec is usually 100 on the BMC
-    const long ticksPerSec = 100;
+    metric_blob::ProcFileReader reader;
+    std::string_view stat = reader.read(getpid(), "stat");
+    EXPECT_TRUE(stat.starts_with(std::to_string(getpid()) + " ("));
+}
+
+TEST(FdCounter, countsOwnDescriptors)
+{
+    metric_blob::FdCounter counter;
+    // Walking our own fd directory also sees the descriptor used for the
+    // walk, so only compare differences.
+    const int entriesBefore = counter.countEntries(getpid());
+    const int countBefore = counter.count(getpid());
+    ASSERT_GT(entriesBefore, 0);
+    ASSERT_GT(countBefore, 0);
+
+    int fds[16];
+    for (int& fd : fds)
+    {
+        fd = dup(STDERR_FILENO);
+        ASSERT_GE(fd, 0);
+    }
+    EXPECT_EQ(counter.countEntries(getpid()), entriesBefore + 16);
+    EXPECT_EQ(counter.count(getpid()), countBefore + 16);
+    for (int fd : fds)
+    {
+        close(fd);
+    }
+}
+
+TEST(FdCounter, inexistentProcess)
+{
+    metric_blob::FdCounter counter;
+    // Larger than any pid_max.
+    EXPECT_EQ(counter.count(1 << 30), -1);
+    EXPECT_EQ(counter.countEntries(1 << 30), -1);
+}
 
+TEST(ProcPidStat, allFields)
+{
     const std::string_view content =
         "2596 (dbus-broker) R 2577 2577 2577 0 -1 "
         "4194560 299 0 1 0 333037 246110 0 0 20 0 "
         "1 0 1545 3411968 530 4294967295 65536 "
-        "246512 2930531712 0 0 0 81923 4";
+        "246512 2930531712 0 0 0 81923 4\n";
 
-    metric_blob::TcommUtimeStime t =
-        metric_blob::parseTcommUtimeStimeString(content, ticksPerSec);
-    const float EPS = 0.01; // The difference was 0.000117188
-    EXPECT_LT(std::abs(t.utime - 3330.37), EPS);
-    EXPECT_LT(std::abs(t.stime - 2461.10), EPS);
-    EXPECT_EQ(t.tcomm, "(dbus-broker)");
+    metric_blob::ProcPidStat stat;
+    ASSERT_TRUE(stat.parse(content));
+    using F = metric_blob::ProcPidStat;
+    EXPECT_EQ(stat.field(F::pid), "2596");
+    EXPECT_EQ(stat.field(F::comm), "dbus-broker");
+    EXPECT_EQ(stat.field(F::state), "R");
+    EXPECT_EQ(stat.number(F::ppid), 2577);
+    EXPECT_EQ(stat.number(F::minflt), 299);
+    EXPECT_EQ(stat.number(F::majflt), 1);
+    EXPECT_EQ(stat.number(F::utime), 333037);
+    EXPECT_EQ(stat.number(F::stime), 246110);
+    EXPECT_EQ(stat.number(F::numThreads), 1);
+    EXPECT_EQ(stat.number(F::starttime), 1545);
+    EXPECT_EQ(stat.number(F::vsize), 3411968);
+    EXPECT_EQ(stat.number(F::rss), 530);
+    EXPECT_EQ(stat.number<int>(8), -1);
+    EXPECT_EQ(stat.field(33), "4");
+    EXPECT_EQ(stat.field(34), "");
+    EXPECT_EQ(stat.number(34), 0);
 }
 
-TEST(GetTcommUtimeStime, invalidInput)
+TEST(ProcPidStat, invalidInput)
 {
-    // ticks_per_sec is usually 100 on the BMC
-    const long ticksPerSec = 100;
+    metric_blob::ProcPidStat stat;
+    EXPECT_FALSE(stat.parse(""));
+    EXPECT_FALSE(stat.parse("12 no-parens S 1"));
+    EXPECT_FALSE(stat.parse("12 )backwards( S 1"));
+    EXPECT_FALSE(stat.parse("12 (truncated)"));
+    EXPECT_FALSE(stat.parse(
+        "x invalid x x x x x x x x x x x x x x x x x x x x x x x x x x x"));
+}
 
+TEST(ProcPidStat, commWithSpacesAndParens)
+{
     const std::string_view content =
-        "x invalid x x x x x x x x x x x x x x x x x x x x x x x x x x x";
+        "1234 (my (odd) daemon) S 1 1234 1234 0 -1 "
+        "4194560 299 0 1 0 1500 250 0 0 20 0 "
+        "1 0 1545 3411968 530 4294967295 65536";
 
-    metric_blob::TcommUtimeStime t =
-        metric_blob::parseTcommUtimeStimeString(content, ticksPerSec);
-
-    EXPECT_EQ(t.utime, 0);
-    EXPECT_EQ(t.stime, 0);
-    EXPECT_EQ(t.tcomm, "invalid");
+    metric_blob::ProcPidStat stat;
+    ASSERT_TRUE(stat.parse(content));
+    using F = metric_blob::ProcPidStat;
+    EXPECT_EQ(stat.field(F::comm), "my (odd) daemon");
+    EXPECT_EQ(metric_blob::toTcomm(stat.field(F::comm)), "(my (odd) daemon)");
+    EXPECT_EQ(stat.field(F::state), "S");
+    EXPECT_EQ(stat.number(F::utime), 1500);
+    EXPECT_EQ(stat.number(F::stime), 250);
 }
 
 TEST(ParseMeminfoValue, validInput)
@@ -127,6 +230,133 @@ TEST(ParseMeminfoValue, invalidInput)
     EXPECT_EQ(value, -999);
 }
 
+TEST(ParseProcPidIo, validInput)
+{
+    const std::string_view content = "rchar: 4292\n"
+                                     "wchar: 2630\n"
+                                     "syscr: 13\n"
+                                     "syscw: 9\n"
+                                     "read_bytes: 8192\n"
+                                     "write_bytes: 12288\n"
+                                     "cancelled_write_bytes: 4096\n";
+    metric_blob::ProcPidIo io;
+    EXPECT_TRUE(metric_blob::parseProcPidIo(content, io));
+    EXPECT_EQ(io.readBytes, 8192);
+    EXPECT_EQ(io.writeBytes, 12288);
+}
+
+TEST(ParseProcPidIo, invalidInput)
+{
+    metric_blob::ProcPidIo io;
+    EXPECT_FALSE(metric_blob::parseProcPidIo("", io));
+    EXPECT_FALSE(metric_blob::parseProcPidIo("read_bytes: 1\n", io));
+    EXPECT_FALSE(
+        metric_blob::parseProcPidIo("read_bytes: 1\nwrite_bytes: x\n", io));
+}
+
+TEST(ParsePressure, validInput)
+{
+    const std::string_view content =
+        "some avg10=1.26 avg60=0.39 avg300=0.18 total=24985781\n"
+        "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+    metric_blob::Pressure pressure;
+    EXPECT_TRUE(metric_blob::parsePressure(content, pressure));
+    EXPECT_TRUE(pressure.hasSome);
+    EXPECT_FLOAT_EQ(pressure.some.avg10, 1.26);
+    EXPECT_FLOAT_EQ(pressure.some.avg60, 0.39);
+    EXPECT_FLOAT_EQ(pressure.some.avg300, 0.18);
+    EXPECT_EQ(pressure.some.total, 24985781);
+    EXPECT_TRUE(pressure.hasFull);
+    EXPECT_EQ(pressure.full.total, 0);
+}
+
+TEST(ParsePressure, someOnly)
+{
+    // The cpu file of kernels before 5.13 has no "full" line.
+    metric_blob::Pressure pressure;
+    EXPECT_TRUE(metric_blob::parsePressure(
+        "some avg10=0.00 avg60=0.00 avg300=0.00 total=5", pressure));
+    EXPECT_EQ(pressure.some.total, 5);
+    EXPECT_FALSE(pressure.hasFull);
+}
+
+TEST(ParsePressure, invalidInput)
+{
+    metric_blob::Pressure pressure;
+    EXPECT_FALSE(metric_blob::parsePressure("", pressure));
+    EXPECT_FALSE(metric_blob::parsePressure(
+        "some avg10=x avg60=0.00 avg300=0.00 total=5\n", pressure));
+    EXPECT_FALSE(
+        metric_blob::parsePressure("some avg10=0.00 total=5\n", pressure));
+}
+
+TEST(ParseNetDevLine, validInput)
+{
+    std::string_view name;
+    metric_blob::NetDevCounters c;
+    EXPECT_TRUE(metric_blob::parseNetDevLine(
+        "  eth0: 1000 10 1 2 0 0 0 3 2000 20 4 5 0 0 0 0", name, c));
+    EXPECT_EQ(name, "eth0");
+    EXPECT_EQ(c.rxBytes, 1000);
+    EXPECT_EQ(c.rxPackets, 10);
+    EXPECT_EQ(c.rxErrors, 1);
+    EXPECT_EQ(c.rxDrops, 2);
+    EXPECT_EQ(c.txBytes, 2000);
+    EXPECT_EQ(c.txPackets, 20);
+    EXPECT_EQ(c.txErrors, 4);
+    EXPECT_EQ(c.txDrops, 5);
+
+    // Large counters leave no space after the colon.
+    EXPECT_TRUE(metric_blob::parseNetDevLine(
+        "ncsi0:12345678901 1 0 0 0 0 0 0 5 1 0 0 0 0 0 0", name, c));
+    EXPECT_EQ(name, "ncsi0");
+    EXPECT_EQ(c.rxBytes, 12345678901);
+}
+
+TEST(ParseNetDevLine, invalidInput)
+{
+    std::string_view name;
+    metric_blob::NetDevCounters c;
+    EXPECT_FALSE(metric_blob::parseNetDevLine(
+        "Inter-|   Receive                            |  Transmit", name, c));
+    EXPECT_FALSE(metric_blob::parseNetDevLine(
+        " face |bytes    packets errs drop fifo frame compressed multicast|"
+        "bytes    packets errs drop fifo colls carrier compressed",
+        name, c));
+    EXPECT_FALSE(metric_blob::parseNetDevLine("eth0: 1 2 3", name, c));
+}
+
+TEST(ParseProcStatCpuLine, validInput)
+{
+    int cpu = 0;
+    metric_blob::CpuTimes t;
+    EXPECT_TRUE(metric_blob::parseProcStatCpuLine(
+        "cpu  32921 5 3837 148709 4717 6 3 916 0 0", cpu, t));
+    EXPECT_EQ(cpu, -1);
+    EXPECT_EQ(t.user, 32921);
+    EXPECT_EQ(t.nice, 5);
+    EXPECT_EQ(t.system, 3837);
+    EXPECT_EQ(t.idle, 148709);
+    EXPECT_EQ(t.iowait, 4717);
+    EXPECT_EQ(t.irq, 6);
+    EXPECT_EQ(t.softirq, 3);
+    EXPECT_EQ(t.steal, 916);
+
+    EXPECT_TRUE(
+        metric_blob::parseProcStatCpuLine("cpu12 1 2 3 4 5 6 7 8", cpu, t));
+    EXPECT_EQ(cpu, 12);
+    EXPECT_EQ(t.steal, 8);
+}
+
+TEST(ParseProcStatCpuLine, invalidInput)
+{
+    int cpu = 0;
+    metric_blob::CpuTimes t;
+    EXPECT_FALSE(metric_blob::parseProcStatCpuLine("intr 238054 0 0", cpu, t));
+    EXPECT_FALSE(metric_blob::parseProcStatCpuLine("cpu0 1 2", cpu, t));
+    EXPECT_FALSE(metric_blob::parseProcStatCpuLine("cpux 1 2 3 4", cpu, t));
+}
+
 TEST(ParseProcUptime, validInput)
 {
     const std::string_view content = "266923.67 512184.95";
@@ -139,6 +369,53 @@ TEST(ParseProcUptime, validInput)
     EXPECT_LT(abs(idleProcessTime - 512184.95), eps);
 }
 
+TEST(ToBootDurations, withInitrd)
+{
+    metric_blob::BootTimesMonotonic btm;
+    btm.firmwareTime = 9000000;
+    btm.loaderTime = 2000000;
+    btm.initrdTime = 3000000;
+    btm.userspaceTime = 5000000;
+    btm.finishTime = 45000000;
+    auto boot = metric_blob::toBootDurations(btm, 100);
+    EXPECT_DOUBLE_EQ(boot.firmwareSec, 7);
+    EXPECT_DOUBLE_EQ(boot.loaderSec, 2);
+    EXPECT_DOUBLE_EQ(boot.kernelSec, 3);
+    EXPECT_DOUBLE_EQ(boot.initrdSec, 2);
+    EXPECT_DOUBLE_EQ(boot.userspaceSec, 40);
+}
+
+TEST(ToBootDurations, powerOnCounter)
+{
+    metric_blob::BootTimesMonotonic btm;
+    btm.userspaceTime = 4000000;
+    btm.finishTime = 10000000;
+    btm.powerOnSecCounterTime = 130;
+    auto boot = metric_blob::toBootDurations(btm, 100.5);
+    EXPECT_DOUBLE_EQ(boot.firmwareSec, 29.5);
+    EXPECT_DOUBLE_EQ(boot.kernelSec, 4);
+    EXPECT_DOUBLE_EQ(boot.initrdSec, 0);
+    EXPECT_DOUBLE_EQ(boot.userspaceSec, 6);
+}
+
+TEST(UpdateEccCounts, onlyPresentCounts)
+{
+    metric_blob::EccCounts counts = {1, 2};
+    EXPECT_EQ(metric_blob::updateEccCounts({{"ceCount", uint64_t{5}},
+                                            {"isLoggingLimitReached",
+                                             uint8_t{0}}},
+                                           counts),
+              1);
+    EXPECT_EQ(counts.correctableErrCount, 5);
+    EXPECT_EQ(counts.uncorrectableErrCount, 2);
+
+    EXPECT_EQ(metric_blob::updateEccCounts(
+                  {{"ceCount", uint64_t{6}}, {"ueCount", uint64_t{7}}}, counts),
+              2);
+    EXPECT_EQ(counts.correctableErrCount, 6);
+    EXPECT_EQ(counts.uncorrectableErrCount, 7);
+}
+
 TEST(TrimStringRight, nonEmptyResult)
 {
     EXPECT_EQ(
@@ -0,0 +1,112 @@
+// Copyright 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace metric_blob
+{
+
+/**
+ * Picks the K best ranked of a stream of entries and folds every other one
+ * into an aggregate, which is how the per-process sections report their top
+ * processes followed by "(Others)".
+ *
+ * Entries are ranked by the key that Key returns for them, smallest first,
+ * so a key is typically a tuple with the metric negated followed by tie
+ * breakers. Keys are compared with operator< and may hold references into
+ * the entry, so ranking never copies a string. Only pointers to the entries
+ * are kept, in a heap of at most K, which makes ranking n entries
+ * O(n log K).
+ *
+ * @tparam T: type of the ranked entries, which must outlive the TopK
+ * @tparam Key: callable returning the ranking key of a const T&
+ * @tparam Fold: callable receiving each const T& that is not in the top K
+ */
+template <typename T, typename Key, typename Fold>
+class TopK
+{
+  public:
+    /**
+     * @param k: how many entries to keep; 0 folds all of them
+     * @param key: returns the ranking key of an entry
+     * @param fold: called once for every entry that ends up outside the top
+     */
+    TopK(size_t k, Key key, Fold fold) :
+        k(k), key(std::move(key)), fold(std::move(fold))
+    {
+        heap.reserve(k);
+    }
+
+    /** Ranks one more entry. */
+    void add(const T& entry)
+    {
+        if (heap.size() < k)
+        {
+            heap.push_back(&entry);
+            std::push_heap(heap.begin(), heap.end(), worse());
+            return;
+        }
+        // The heap is ordered so that its front is the worst of the top K.
+        if (k > 0 && key(entry) < key(*heap.front()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), worse());
+            fold(*heap.back());
+            heap.back() = &entry;
+            std::push_heap(heap.begin(), heap.end(), worse());
+            return;
+        }
+        fold(entry);
+    }
+
+    /**
+     * Returns the top entries, best ranked first. Ranking may not continue
+     * afterwards.
+     */
+    std::vector<const T*> take()
+    {
+        std::sort_heap(heap.begin(), heap.end(), worse());
+        return std::move(heap);
+    }
+
+  private:
+    // Heap comparator putting the worst ranked entry at the front.
+    auto worse() const
+    {
+        return [this](const T* a, const T* b) { return key(*a) < key(*b); };
+    }
+
+    size_t k;
+    Key key;
+    Fold fold;
+    std::vector<const T*> heap;
+};
+
+/**
+ * Creates a TopK, deducing everything but the entry type.
+ * @param k: how many entries to keep
+ * @param key: returns the ranking key of a const T&
+ * @param fold: called once for every const T& outside the top
+ */
+template <typename T, typename Key, typename Fold>
+TopK<T, Key, Fold> makeTopK(size_t k, Key key, Fold fold)
+{
+    return TopK<T, Key, Fold>(k, std::move(key), std::move(fold));
+}
+
+} // namespace metric_blob
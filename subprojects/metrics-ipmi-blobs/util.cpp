@@ -14,6 +14,7 @@
 
 #include "util.hpp"
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -23,10 +24,12 @@
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/message.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
 #include <cmath>
 #include <cstdlib>
-#include <fstream>
-#include <sstream>
+#include <cstring>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -54,23 +57,144 @@ long getTicksPerSec()
     return sysconf(_SC_CLK_TCK);
 }
 
-std::string readFileThenGrepIntoString(const std::string_view fileName,
-                                       const std::string_view grepStr)
+// Writes "/proc/<pid>/<leaf>" into path and returns false if it does not fit.
+template <size_t N>
+static bool procPidPath(char (&path)[N], const int pid,
+                        const std::string_view leaf)
 {
-    std::stringstream ss;
-    std::ifstream ifs(fileName.data());
-    while (ifs.good())
+    constexpr std::string_view prefix = "/proc/";
+    // Up to 10 digits and the '/' and NUL around them.
+    if (prefix.size() + 12 + leaf.size() > N)
     {
-        std::string line;
-        std::getline(ifs, line);
-        if (line.find(grepStr) != std::string::npos)
+        return false;
+    }
+    char* p = std::copy(prefix.begin(), prefix.end(), path);
+    p = std::to_chars(p, path + N, pid).ptr;
+    *p++ = '/';
+    p = std::copy(leaf.begin(), leaf.end(), p);
+    *p = '\0';
+    return true;
+}
+
+// Keeps only the lines of data[0, size) that contain grepStr, moving them to
+// the front of the buffer, and returns the new size.
+size_t grepLinesInPlace(char* data, const size_t size,
+                        const std::string_view grepStr)
+{
+    size_t out = 0;
+    size_t pos = 0;
+    while (pos < size)
+    {
+        const char* nl =
+            static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+        const size_t end = nl != nullptr ? nl - data + 1 : size;
+        const std::string_view line(data + pos, end - pos);
+        if (line.find(grepStr) != std::string_view::npos)
         {
-            ss << line;
+            memmove(data + out, data + pos, line.size());
+            out += line.size();
         }
-        if (ifs.good())
-            ss << std::endl;
+        pos = end;
     }
-    return ss.str();
+    return out;
+}
+
+std::string_view ProcFileReader::read(const char* path,
+                                      const std::string_view grepStr)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return failed(errno);
+    }
+    size_t size = fill(fd, false, lastError);
+    close(fd);
+
+    if (!grepStr.empty())
+    {
+        size = grepLinesInPlace(buffer.data(), size, grepStr);
+    }
+    buffer[size] = '\0';
+    return std::string_view(buffer.data(), size);
+}
+
+std::string_view ProcFileReader::read(const int pid,
+                                      const std::string_view leaf)
+{
+    char path[64];
+    if (!procPidPath(path, pid, leaf))
+    {
+        return failed(ENAMETOOLONG);
+    }
+    return read(path);
+}
+
+std::string_view ProcFileReader::failed(const int error)
+{
+    lastError = error;
+    if (buffer.empty())
+    {
+        buffer.resize(4096);
+    }
+    buffer[0] = '\0';
+    return std::string_view(buffer.data(), 0);
+}
+
+std::string_view ProcFileReader::pread(const int fd, int& error)
+{
+    size_t size = fill(fd, true, error);
+    lastError = error;
+    buffer[size] = '\0';
+    return std::string_view(buffer.data(), size);
+}
+
+size_t ProcFileReader::fill(const int fd, const bool positional, int& error)
+{
+    // procfs reports a size of 0 for most files, so read until EOF and grow
+    // the buffer whenever a read fills it.
+    if (buffer.empty())
+    {
+        buffer.resize(4096);
+    }
+    error = 0;
+    size_t size = 0;
+    while (true)
+    {
+        // Always leave room for the terminating NUL.
+        if (size + 1 >= buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+        char* dst = buffer.data() + size;
+        size_t len = buffer.size() - size - 1;
+        ssize_t r = positional ? ::pread(fd, dst, len, size)
+                               : ::read(fd, dst, len);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r < 0)
+        {
+            // e.g. ESRCH when the process exited after open().
+            error = errno;
+            return 0;
+        }
+        if (r == 0)
+        {
+            return size;
+        }
+        size += r;
+    }
+}
+
+int openProcPidFile(const int pid, const std::string_view leaf)
+{
+    char path[64];
+    if (!procPidPath(path, pid, leaf))
+    {
+        return -1;
+    }
+    return open(path, O_RDONLY | O_CLOEXEC);
 }
 
 bool isNumericPath(const std::string_view path, int& value)
@@ -109,92 +233,156 @@ std::string trimStringRight(std::string_view s)
     return ret;
 }
 
-std::string getCmdLine(const int pid)
+std::string getCmdLine(ProcFileReader& reader, const int pid)
 {
-    const std::string& cmdlinePath =
-        "/proc/" + std::to_string(pid) + "/cmdline";
+    return formatCmdLine(reader.read(pid, "cmdline"));
+}
 
-    std::string cmdline = readFileThenGrepIntoString(cmdlinePath);
-    for (size_t i = 0; i < cmdline.size(); ++i)
+std::string formatCmdLine(std::string_view content)
+{
+    // Trim the trailing NUL and any other control characters.
+    while (!content.empty() && content.back() <= 32)
     {
-        cmdline[i] = controlCharsToSpace(cmdline[i]);
+        content.remove_suffix(1);
     }
 
-    // Trim empty strings
-    cmdline = trimStringRight(cmdline);
-
+    // Arguments are NUL-separated.
+    std::string cmdline(content.size(), ' ');
+    std::transform(content.begin(), content.end(), cmdline.begin(),
+                   controlCharsToSpace);
     return cmdline;
 }
 
-// strtok is used in this function in order to avoid usage of <sstream>.
-// However, that would require us to create a temporary std::string.
-TcommUtimeStime parseTcommUtimeStimeString(std::string_view content,
-                                           const long ticksPerSec)
+std::string toTcomm(std::string_view comm)
 {
-    TcommUtimeStime ret;
-    ret.tcomm = "";
-    ret.utime = ret.stime = 0;
+    std::string tcomm;
+    tcomm.reserve(comm.size() + 2);
+    tcomm += '(';
+    tcomm += comm;
+    tcomm += ')';
+    return tcomm;
+}
 
-    const float invTicksPerSec = 1.0f / static_cast<float>(ticksPerSec);
+FdCounter::FdCounter()
+{
+    // This process always has descriptors open, so a size of 0 here means the
+    // kernel predates fd counts in st_size.
+    struct stat st;
+    sizeIsCount = stat("/proc/self/fd", &st) == 0 && st.st_size > 0;
+}
 
-    // pCol now points to the first part in content after content is split by
-    // space.
-    // This is not ideal,
-    std::string temp(content);
-    char* pCol = strtok(temp.data(), " ");
+int FdCounter::count(const int pid)
+{
+    if (sizeIsCount)
+    {
+        char path[32];
+        struct stat st;
+        if (!procPidPath(path, pid, "fd") || stat(path, &st) < 0)
+        {
+            return -1;
+        }
+        return static_cast<int>(st.st_size);
+    }
+    return countEntries(pid);
+}
+
+int FdCounter::countEntries(const int pid)
+{
+    char path[32];
+    if (!procPidPath(path, pid, "fd"))
+    {
+        return -1;
+    }
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
 
-    if (pCol != nullptr)
+    // Large enough for a few thousand entries per call.
+    if (buffer.empty())
+    {
+        buffer.resize(64 * 1024);
+    }
+    int entries = 0;
+    while (true)
     {
-        const int fields[] = {1, 13, 14}; // tcomm, utime, stime
-        int fieldIdx = 0;
-        for (int colIdx = 0; colIdx < 15; ++colIdx)
+        ssize_t r = getdents64(fd, buffer.data(), buffer.size());
+        if (r < 0)
         {
-            if (fieldIdx < 3 && colIdx == fields[fieldIdx])
+            entries = -1;
+            break;
+        }
+        if (r == 0)
+        {
+            break;
+        }
+        for (ssize_t off = 0; off < r;)
+        {
+            const auto* d = reinterpret_cast<const dirent64*>(&buffer[off]);
+            // Every entry except "." and ".." is a descriptor number.
+            if (d->d_name[0] != '.')
             {
-                switch (fieldIdx)
-                {
-                    case 0:
-                    {
-                        ret.tcomm = std::string(pCol);
-                        break;
-                    }
-                    case 1:
-                        [[fallthrough]];
-                    case 2:
-                    {
-                        int ticks = std::atoi(pCol);
-                        float t = static_cast<float>(ticks) * invTicksPerSec;
-
-                        if (fieldIdx == 1)
-                        {
-                            ret.utime = t;
-                        }
-                        else if (fieldIdx == 2)
-                        {
-                            ret.stime = t;
-                        }
-                        break;
-                    }
-                }
-                ++fieldIdx;
+                ++entries;
             }
-            pCol = strtok(nullptr, " ");
+            off += d->d_reclen;
         }
     }
+    close(fd);
+    return entries;
+}
+
+bool ProcPidStat::parse(const std::string_view content, const size_t lastField)
+{
+    count = 0;
 
-    if (ticksPerSec <= 0)
+    const size_t open = content.find('(');
+    if (open == std::string_view::npos)
     {
-        log<level::ERR>("ticksPerSec is equal or less than zero");
+        return false;
+    }
+    // comm may contain ')' itself but no later field does, so it ends at the
+    // last one. memrchr is much faster than string_view::rfind here.
+    const char* closePtr = static_cast<const char*>(
+        memrchr(content.data() + open, ')', content.size() - open));
+    if (closePtr == nullptr)
+    {
+        return false;
     }
+    const size_t close = closePtr - content.data();
 
-    return ret;
-}
+    std::string_view pidField = content.substr(0, open);
+    while (!pidField.empty() && pidField.back() == ' ')
+    {
+        pidField.remove_suffix(1);
+    }
+    fields[Field::pid] = pidField;
+    fields[Field::comm] = content.substr(open + 1, close - open - 1);
+
+    const size_t last = std::min(lastField, maxFields);
+    const char* p = content.data() + close + 1;
+    const char* const end = content.data() + content.size();
+    size_t n = Field::state;
+    while (n <= last)
+    {
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+        if (p == end || *p == '\n')
+        {
+            break;
+        }
+        const char* begin = p;
+        while (p < end && *p != ' ' && *p != '\n')
+        {
+            ++p;
+        }
+        fields[n++] = std::string_view(begin, p - begin);
+    }
+    count = n;
 
-TcommUtimeStime getTcommUtimeStime(const int pid, const long ticksPerSec)
-{
-    const std::string& statPath = "/proc/" + std::to_string(pid) + "/stat";
-    return parseTcommUtimeStimeString(readFileThenGrepIntoString(statPath),
-                                      ticksPerSec);
+    return count > Field::state;
 }
 
 // Returns true if successfully parsed and false otherwise. If parsing was
@@ -219,6 +407,219 @@ bool parseMeminfoValue(const std::string_view content,
     return false;
 }
 
+bool parseProcPidIo(std::string_view content, ProcPidIo& io)
+{
+    bool hasRead = false;
+    bool hasWrite = false;
+    while (!content.empty())
+    {
+        size_t eol = content.find('\n');
+        std::string_view line = content.substr(0, eol);
+        content = eol == std::string_view::npos ? std::string_view()
+                                                : content.substr(eol + 1);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+        {
+            continue;
+        }
+        std::string_view key = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ')
+        {
+            value.remove_prefix(1);
+        }
+
+        uint64_t* field = nullptr;
+        if (key == "read_bytes")
+        {
+            field = &io.readBytes;
+            hasRead = true;
+        }
+        else if (key == "write_bytes")
+        {
+            field = &io.writeBytes;
+            hasWrite = true;
+        }
+        else
+        {
+            continue;
+        }
+        auto [ptr, ec] =
+            std::from_chars(value.data(), value.data() + value.size(), *field);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+    }
+    return hasRead && hasWrite;
+}
+
+// Parses "avg10=0.12 avg60=0.05 avg300=0.01 total=123456".
+static bool parsePressureStall(std::string_view line, PressureStall& stall)
+{
+    int found = 0;
+    while (!line.empty())
+    {
+        size_t end = line.find(' ');
+        std::string_view token = line.substr(0, end);
+        line = end == std::string_view::npos ? std::string_view()
+                                             : line.substr(end + 1);
+
+        size_t eq = token.find('=');
+        if (eq == std::string_view::npos)
+        {
+            continue;
+        }
+        std::string_view key = token.substr(0, eq);
+        const char* first = token.data() + eq + 1;
+        const char* last = token.data() + token.size();
+        std::from_chars_result res{};
+        if (key == "avg10")
+        {
+            res = std::from_chars(first, last, stall.avg10);
+        }
+        else if (key == "avg60")
+        {
+            res = std::from_chars(first, last, stall.avg60);
+        }
+        else if (key == "avg300")
+        {
+            res = std::from_chars(first, last, stall.avg300);
+        }
+        else if (key == "total")
+        {
+            res = std::from_chars(first, last, stall.total);
+        }
+        else
+        {
+            continue;
+        }
+        if (res.ec != std::errc())
+        {
+            return false;
+        }
+        ++found;
+    }
+    return found == 4;
+}
+
+bool parsePressure(std::string_view content, Pressure& pressure)
+{
+    while (!content.empty())
+    {
+        size_t eol = content.find('\n');
+        std::string_view line = content.substr(0, eol);
+        content = eol == std::string_view::npos ? std::string_view()
+                                                : content.substr(eol + 1);
+
+        if (line.starts_with("some "))
+        {
+            pressure.hasSome = parsePressureStall(line.substr(5), pressure.some);
+        }
+        else if (line.starts_with("full "))
+        {
+            pressure.hasFull = parsePressureStall(line.substr(5), pressure.full);
+        }
+    }
+    return pressure.hasSome;
+}
+
+bool parseNetDevLine(std::string_view line, std::string_view& name,
+                     NetDevCounters& counters)
+{
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+    {
+        return false;
+    }
+    name = line.substr(0, colon);
+    name.remove_prefix(std::min(name.find_first_not_of(' '), name.size()));
+    if (name.empty())
+    {
+        return false;
+    }
+
+    // Receive: bytes packets errs drop fifo frame compressed multicast,
+    // then transmit: bytes packets errs drop fifo colls carrier compressed.
+    constexpr size_t numValues = 16;
+    std::array<uint64_t, numValues> values;
+    const char* p = line.data() + colon + 1;
+    const char* end = line.data() + line.size();
+    for (uint64_t& value : values)
+    {
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+        auto [ptr, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        p = ptr;
+    }
+
+    counters = NetDevCounters{
+        .rxBytes = values[0],
+        .rxPackets = values[1],
+        .rxErrors = values[2],
+        .rxDrops = values[3],
+        .txBytes = values[8],
+        .txPackets = values[9],
+        .txErrors = values[10],
+        .txDrops = values[11],
+    };
+    return true;
+}
+
+bool parseProcStatCpuLine(std::string_view line, int& cpu, CpuTimes& times)
+{
+    if (!line.starts_with("cpu"))
+    {
+        return false;
+    }
+    const char* p = line.data() + 3;
+    const char* end = line.data() + line.size();
+    cpu = -1;
+    if (p < end && *p != ' ')
+    {
+        auto [ptr, ec] = std::from_chars(p, end, cpu);
+        if (ec != std::errc() || cpu < 0)
+        {
+            return false;
+        }
+        p = ptr;
+    }
+
+    // Kernels before 2.6.11 stop before steal, and later ones add guest
+    // times which are already included in user and nice.
+    uint64_t* fields[] = {&times.user,   &times.nice,   &times.system,
+                          &times.idle,   &times.iowait, &times.irq,
+                          &times.softirq, &times.steal};
+    times = {};
+    size_t parsed = 0;
+    for (uint64_t* field : fields)
+    {
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+        if (p == end)
+        {
+            break;
+        }
+        auto [ptr, ec] = std::from_chars(p, end, *field);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        p = ptr;
+        ++parsed;
+    }
+    return parsed >= 4;
+}
+
 bool parseProcUptime(const std::string_view content, double& uptime,
                      double& idleProcessTime)
 {
@@ -277,7 +678,7 @@ bool readMem(const uint32_t target, uint32_t& memResult)
  *                                                                            |----------------------| <--- userspaceTime=finish-userspace
  */
 // clang-format on
-bool getBootTimesMonotonic(BootTimesMonotonic& btm)
+bool getBootTimesMonotonic(sdbusplus::bus_t& bus, BootTimesMonotonic& btm)
 {
     // Timestamp name and its offset in the struct.
     std::vector<std::pair<std::string_view, size_t>> timeMap = {
@@ -290,12 +691,11 @@ bool getBootTimesMonotonic(BootTimesMonotonic& btm)
          offsetof(BootTimesMonotonic, userspaceTime)},
         {"FinishTimestampMonotonic", offsetof(BootTimesMonotonic, finishTime)}};
 
-    auto b = sdbusplus::bus::new_default_system();
-    auto m = b.new_method_call("org.freedesktop.systemd1",
-                               "/org/freedesktop/systemd1",
-                               "org.freedesktop.DBus.Properties", "GetAll");
+    auto m = bus.new_method_call("org.freedesktop.systemd1",
+                                 "/org/freedesktop/systemd1",
+                                 "org.freedesktop.DBus.Properties", "GetAll");
     m.append("");
-    auto reply = b.call(m);
+    auto reply = bus.call(m);
     auto timestamps = reply.unpack<
         std::vector<std::pair<std::string, std::variant<uint64_t>>>>();
 
@@ -326,10 +726,10 @@ bool getBootTimesMonotonic(BootTimesMonotonic& btm)
         return false;
     }
 
-    std::string cpuinfo =
-        readFileThenGrepIntoString("/proc/cpuinfo", "Hardware");
+    ProcFileReader reader;
+    std::string_view cpuinfo = reader.read("/proc/cpuinfo", "Hardware");
     // Nuvoton NPCM7XX chip has a counter which starts from power-on.
-    if (cpuinfo.find("NPCM7XX") != std::string::npos)
+    if (cpuinfo.find("NPCM7XX") != std::string_view::npos)
     {
         // Get elapsed seconds from SEC_CNT register
         const uint32_t SEC_CNT_ADDR = 0xf0801068;
@@ -348,52 +748,78 @@ bool getBootTimesMonotonic(BootTimesMonotonic& btm)
     return true;
 }
 
-bool getECCErrorCounts(EccCounts& eccCounts)
+BootDurations toBootDurations(const BootTimesMonotonic& btm, double uptime)
 {
-    std::vector<
-        std::pair<std::string, std::variant<uint64_t, uint8_t, std::string>>>
-        values;
-    try
+    BootDurations ret;
+    if (btm.firmwareTime == 0 && btm.powerOnSecCounterTime != 0)
     {
-        auto bus = sdbusplus::bus::new_default_system();
-        auto m =
-            bus.new_method_call("xyz.openbmc_project.memory.ECC",
-                                "/xyz/openbmc_project/metrics/memory/BmcECC",
-                                "org.freedesktop.DBus.Properties", "GetAll");
-        m.append("xyz.openbmc_project.Memory.MemoryECC");
-        auto reply = bus.call(m);
-        reply.read(values);
+        ret.firmwareSec =
+            static_cast<double>(btm.powerOnSecCounterTime) - uptime;
     }
-    catch (const sdbusplus::exception::internal_exception& ex)
+    else
     {
-        return false;
+        ret.firmwareSec =
+            static_cast<double>(btm.firmwareTime - btm.loaderTime) / 1e6;
+    }
+    ret.loaderSec = static_cast<double>(btm.loaderTime) / 1e6;
+    if (btm.initrdTime != 0)
+    {
+        ret.kernelSec = static_cast<double>(btm.initrdTime) / 1e6;
+        ret.initrdSec =
+            static_cast<double>(btm.userspaceTime - btm.initrdTime) / 1e6;
     }
+    else
+    {
+        ret.kernelSec = static_cast<double>(btm.userspaceTime) / 1e6;
+        ret.initrdSec = 0;
+    }
+    ret.userspaceSec =
+        static_cast<double>(btm.finishTime - btm.userspaceTime) / 1e6;
+    return ret;
+}
+
+int updateEccCounts(const EccProperties& properties, EccCounts& eccCounts)
+{
     bool hasCorrectable = false;
     bool hasUncorrectable = false;
-    for (const auto& [key, value] : values)
+    for (const auto& [key, value] : properties)
     {
+        const uint64_t* count = std::get_if<uint64_t>(&value);
+        if (count == nullptr)
+        {
+            continue;
+        }
         if (key == "ceCount")
         {
-            eccCounts.correctableErrCount =
-                static_cast<int32_t>(std::get<uint64_t>(value));
+            eccCounts.correctableErrCount = static_cast<int32_t>(*count);
             hasCorrectable = true;
-            if (hasUncorrectable)
-            {
-                return true;
-            }
         }
-        if (key == "ueCount")
+        else if (key == "ueCount")
         {
-            eccCounts.uncorrectableErrCount =
-                static_cast<int32_t>(std::get<uint64_t>(value));
+            eccCounts.uncorrectableErrCount = static_cast<int32_t>(*count);
             hasUncorrectable = true;
-            if (hasCorrectable)
-            {
-                return true;
-            }
         }
     }
-    return false;
+    return hasCorrectable + hasUncorrectable;
+}
+
+bool getECCErrorCounts(sdbusplus::bus_t& bus, EccCounts& eccCounts)
+{
+    EccProperties values;
+    try
+    {
+        auto m = bus.new_method_call(eccService, eccPath,
+                                     "org.freedesktop.DBus.Properties",
+                                     "GetAll");
+        m.append(eccInterface);
+        auto reply = bus.call(m);
+        reply.read(values);
+    }
+    catch (const sdbusplus::exception::internal_exception& ex)
+    {
+        return false;
+    }
+    return updateEccCounts(values, eccCounts) == 2;
 }
 
 } // namespace metric_blob
@@ -14,20 +14,20 @@
 
 #pragma once
 
+#include <sdbusplus/bus.hpp>
+
+#include <array>
+#include <charconv>
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace metric_blob
 {
 
-struct TcommUtimeStime
-{
-    std::string tcomm;
-    float utime;
-    float stime;
-};
-
 struct BootTimesMonotonic
 {
     uint64_t firmwareTime = 0;
@@ -38,19 +38,282 @@ struct BootTimesMonotonic
     uint64_t powerOnSecCounterTime = 0;
 };
 
-TcommUtimeStime parseTcommUtimeStimeString(std::string_view content,
-                                           long ticksPerSec);
-std::string readFileThenGrepIntoString(std::string_view fileName,
-                                       std::string_view grepStr = "");
+/** How long each stage of the boot took, in seconds. */
+struct BootDurations
+{
+    double firmwareSec = 0;
+    double loaderSec = 0;
+    double kernelSec = 0;
+    double initrdSec = 0;
+    double userspaceSec = 0;
+};
+
+/**
+ * Storage I/O counters of /proc/<pid>/io: bytes the process caused to be
+ * fetched from or sent to the storage layer, as opposed to rchar/wchar which
+ * also count page cache hits, pipes and sockets.
+ */
+struct ProcPidIo
+{
+    uint64_t readBytes = 0;
+    uint64_t writeBytes = 0;
+};
+
+/**
+ * One line of a /proc/pressure file: the share of wall time some or all
+ * tasks were stalled on the resource, averaged over 10, 60 and 300 seconds
+ * in percent, and the total stall time in microseconds.
+ */
+struct PressureStall
+{
+    float avg10 = 0;
+    float avg60 = 0;
+    float avg300 = 0;
+    uint64_t total = 0;
+};
+
+/** Pressure Stall Information of one resource. */
+struct Pressure
+{
+    bool hasSome = false;
+    PressureStall some;
+    // Only reported for cpu since Linux 5.13.
+    bool hasFull = false;
+    PressureStall full;
+};
+
+/** Counters of one network interface in /proc/net/dev. */
+struct NetDevCounters
+{
+    uint64_t rxBytes = 0;
+    uint64_t rxPackets = 0;
+    uint64_t rxErrors = 0;
+    uint64_t rxDrops = 0;
+    uint64_t txBytes = 0;
+    uint64_t txPackets = 0;
+    uint64_t txErrors = 0;
+    uint64_t txDrops = 0;
+};
+
+/** Time spent by a CPU in each state, in clock ticks, from /proc/stat. */
+struct CpuTimes
+{
+    uint64_t user = 0;
+    uint64_t nice = 0;
+    uint64_t system = 0;
+    uint64_t idle = 0;
+    uint64_t iowait = 0;
+    uint64_t irq = 0;
+    uint64_t softirq = 0;
+    uint64_t steal = 0;
+};
+
+/**
+ * Reads procfs and sysfs files with a single open() and as few read() calls as
+ * the file size allows, into a buffer that is reused across reads. Meant to be
+ * kept for the duration of one snapshot so that collection does not allocate
+ * per file.
+ */
+class ProcFileReader
+{
+  public:
+    /**
+     * Reads a whole file.
+     * @param path: NUL-terminated path of the file
+     * @param grepStr: if not empty, only the lines containing it are kept
+     * @returns The file content, or empty if it could not be read. The view is
+     *     NUL-terminated and stays valid until the next read.
+     */
+    std::string_view read(const char* path, std::string_view grepStr = "");
+
+    /**
+     * Reads /proc/<pid>/<leaf>, see read().
+     */
+    std::string_view read(int pid, std::string_view leaf);
+
+    /**
+     * Reads a whole file that is already open from its start, with pread(),
+     * so that the file can be read again later.
+     * @param error: set to the errno of a failed read, 0 otherwise
+     * @returns See read().
+     */
+    std::string_view pread(int fd, int& error);
+
+    /**
+     * @returns The errno of the last read if it failed, 0 otherwise, which
+     *     tells a process that is gone (ENOENT, ESRCH) from other failures.
+     */
+    int error() const
+    {
+        return lastError;
+    }
+
+    /**
+     * Records error as that of the last read, for a file that could not be
+     * opened elsewhere.
+     * @returns An empty, NUL-terminated view, like a failed read().
+     */
+    std::string_view failed(int error);
+
+  private:
+    /** Reads fd into the buffer; returns the size read. */
+    size_t fill(int fd, bool positional, int& error);
+
+    std::vector<char> buffer;
+    int lastError = 0;
+};
+
+/**
+ * Opens /proc/<pid>/<leaf> for reading.
+ * @returns The fd, or -1 on error.
+ */
+int openProcPidFile(int pid, std::string_view leaf);
+
+/**
+ * Zero-copy parser for the content of /proc/<pid>/stat. comm may itself contain
+ * spaces and ')', so it is taken as everything between the first '(' and the
+ * last ')'; the fields after it are split on spaces. Field numbers follow
+ * proc(5), starting at 1 for pid. The views point into the parsed content.
+ */
+class ProcPidStat
+{
+  public:
+    enum Field : size_t
+    {
+        pid = 1,
+        comm = 2,
+        state = 3,
+        ppid = 4,
+        minflt = 10,
+        majflt = 12,
+        utime = 14,
+        stime = 15,
+        numThreads = 20,
+        starttime = 22,
+        vsize = 23,
+        rss = 24,
+    };
+    // Fields documented as of Linux 6.x; any further ones are ignored.
+    static constexpr size_t maxFields = 52;
+
+    /**
+     * @param content: the stat line, which must outlive this object's use
+     * @param lastField: fields after this one are not split, to save time
+     *     when only the first few are needed
+     * @returns true if at least pid, comm and state were found.
+     */
+    bool parse(std::string_view content, size_t lastField = maxFields);
+
+    /**
+     * @returns The raw text of field n, or empty if it is not present.
+     */
+    std::string_view field(size_t n) const
+    {
+        return n < count ? fields[n] : std::string_view{};
+    }
+
+    /**
+     * @returns Field n converted to a number, or 0 if it is absent or not a
+     *     number.
+     */
+    template <typename T = uint64_t>
+    T number(size_t n) const
+    {
+        std::string_view f = field(n);
+        T value = 0;
+        if (std::from_chars(f.data(), f.data() + f.size(), value).ec !=
+            std::errc{})
+        {
+            return 0;
+        }
+        return value;
+    }
+
+  private:
+    std::array<std::string_view, maxFields + 1> fields;
+    // One past the last field found.
+    size_t count = 0;
+};
+
+/**
+ * Counts the open file descriptors of processes. Linux 6.2 and later report
+ * the count as the st_size of /proc/<pid>/fd, which costs a single stat().
+ * On older kernels the directory is walked with getdents64() into a buffer
+ * reused across calls, so that no memory is allocated per descriptor.
+ */
+class FdCounter
+{
+  public:
+    FdCounter();
+
+    /**
+     * @returns The number of open fds of pid, or -1 if they cannot be read.
+     */
+    int count(int pid);
+
+    /**
+     * Counts by walking /proc/<pid>/fd regardless of kernel support for
+     * st_size.
+     * @returns The number of open fds of pid, or -1 if they cannot be read.
+     */
+    int countEntries(int pid);
+
+  private:
+    bool sizeIsCount;
+    std::vector<char> buffer;
+};
+
+size_t grepLinesInPlace(char* data, size_t size, std::string_view grepStr);
 bool isNumericPath(std::string_view path, int& value);
-TcommUtimeStime getTcommUtimeStime(int pid, long ticksPerSec);
-std::string getCmdLine(int pid);
+std::string getCmdLine(ProcFileReader& reader, int pid);
+/** Turns the content of /proc/<pid>/cmdline into a printable string. */
+std::string formatCmdLine(std::string_view content);
+/** Returns comm in parentheses, the way it is reported after a cmdline. */
+std::string toTcomm(std::string_view comm);
 bool parseMeminfoValue(std::string_view content, std::string_view keyword,
                        int& value);
+/**
+ * Parses the content of /proc/<pid>/io without allocating.
+ * @param content: file content
+ * @param io: filled with the counters
+ * @returns false if read_bytes or write_bytes is missing
+ */
+bool parseProcPidIo(std::string_view content, ProcPidIo& io);
+/**
+ * Parses the content of /proc/pressure/{cpu,memory,io} without allocating.
+ * @param content: file content
+ * @param pressure: filled with the lines found
+ * @returns false if the "some" line is missing or malformed
+ */
+bool parsePressure(std::string_view content, Pressure& pressure);
+/**
+ * Parses one interface line of /proc/net/dev without allocating.
+ * @param line: the line, without its trailing newline
+ * @param name: set to the interface name, pointing into line
+ * @param counters: filled with the interface counters
+ * @returns false for the header lines and malformed lines
+ */
+bool parseNetDevLine(std::string_view line, std::string_view& name,
+                     NetDevCounters& counters);
+/**
+ * Parses one "cpu" or "cpu<N>" line of /proc/stat without allocating.
+ * @param line: the line, without its trailing newline
+ * @param cpu: set to N, or to -1 for the line summing all CPUs
+ * @param times: filled with the time spent in each state
+ * @returns false for the other lines of /proc/stat and malformed lines
+ */
+bool parseProcStatCpuLine(std::string_view line, int& cpu, CpuTimes& times);
 bool parseProcUptime(const std::string_view content, double& uptime,
                      double& idleProcessTime);
 bool readMem(const uint32_t target, uint32_t& memResult);
-bool getBootTimesMonotonic(BootTimesMonotonic& btm);
+bool getBootTimesMonotonic(sdbusplus::bus_t& bus, BootTimesMonotonic& btm);
+
+/**
+ * Splits the boot into stages.
+ * @param btm: boot timestamps
+ * @param uptime: uptime when btm.powerOnSecCounterTime was read
+ */
+BootDurations toBootDurations(const BootTimesMonotonic& btm, double uptime);
 long getTicksPerSec();
 char controlCharsToSpace(char c);
 std::string trimStringRight(std::string_view s);
@@ -61,6 +324,21 @@ struct EccCounts
     int32_t uncorrectableErrCount;
 };
 
-bool getECCErrorCounts(EccCounts& eccCounts);
+// Where the BMC's ECC error counts are published.
+constexpr const char* eccService = "xyz.openbmc_project.memory.ECC";
+constexpr const char* eccPath = "/xyz/openbmc_project/metrics/memory/BmcECC";
+constexpr const char* eccInterface = "xyz.openbmc_project.Memory.MemoryECC";
+
+/** Properties of the ECC interface. */
+using EccProperties = std::vector<
+    std::pair<std::string, std::variant<uint64_t, uint8_t, std::string>>>;
+
+/**
+ * Updates eccCounts from the ECC properties that are present.
+ * @returns How many of the two counts were present.
+ */
+int updateEccCounts(const EccProperties& properties, EccCounts& eccCounts);
+
+bool getECCErrorCounts(sdbusplus::bus_t& bus, EccCounts& eccCounts);
 
 } // namespace metric_blob